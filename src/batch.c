@@ -0,0 +1,376 @@
+/*======================================================================
+
+	University College Dublin
+	COMP20200 - UNIX Programming
+
+	Assignment 2: 	Implement a simple shell
+
+	Project:	assign2_19351611
+	File Name:   	batch.c
+	Description: 	Simple UNIX shell program.
+			Reads line from stdin and executes command.
+			This file contains the builtin command 'batch',
+			which packs items read from stdin or matched by
+			a glob into as few argument vectors as ARG_MAX
+			allows, in the style of xargs.
+
+			These include:
+				> batch_limit()
+				> batch_launch()
+				> batch_reap()
+				> batch_add()
+				> batch_command()
+
+	Author:      	Cian O'Mahoney
+	Student Number:	19351611
+	Email:		cian.omahoney@ucdconnect.ie
+	Date:        	15/2/2021
+	Version:     	1.0
+
+======================================================================*/
+
+
+
+/*======================================================================
+Systems header files
+======================================================================*/
+#include <config.h>
+#include "header.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>	// For strcmp(), strlen(), strdup()
+#include <unistd.h>	// For sysconf(), fork(), dup2()
+#include <fcntl.h>	// For open()
+#include <glob.h>	// For glob(), globfree()
+#include <sys/wait.h>	// For waitpid()
+
+extern char **environ;
+
+
+
+/*======================================================================
+ State of batch currently being filled
+======================================================================*/
+typedef struct
+{
+	char **argv;		// Prefix followed by items, NULL terminated.
+	int prefix;		// Number of prefix arguments in argv.
+	int count;		// Total number of arguments in argv.
+	int capacity;		// Number of pointers allocated for argv.
+	long used;		// Bytes of argument space used by argv.
+	long limit;		// Bytes of argument space available.
+	int jobs;		// Maximum number of batches run at once.
+	int running;		// Number of batches currently running.
+	long launched;		// Number of batches started.
+	pid_t *pids;		// Running batches, oldest first from 'reaped'.
+	long reaped;		// Number of batches waited for.
+	Boolean items_on_stdin;	// Items are read from stdin, not a glob.
+} Batch;
+
+
+
+/*======================================================================
+ * FUNCTION:	batch_limit()
+ * ARGUMENTS:	None.
+ * RETURNS:	Number of bytes available for arguments of a new process.
+ * DESCRIPTION: Function to work out argument space left by ARG_MAX
+ * 		once the environment, which execvp() passes on, and
+ * 		a safety margin have been removed.
+ *====================================================================*/
+static long batch_limit(void)
+{
+	long limit;
+	char **env;
+
+	if((limit = sysconf(_SC_ARG_MAX)) <= 0)
+		limit = BATCH_MIN_ARG_SPACE;
+
+	for(env = environ; *env != NULL; env++)
+		limit -= strlen(*env) + 1 + sizeof(char*);
+
+	limit -= BATCH_HEADROOM;
+
+	return (limit < BATCH_MIN_ARG_SPACE) ? BATCH_MIN_ARG_SPACE : limit;
+
+} // End of 'batch_limit()'.
+
+
+
+/*======================================================================
+ * FUNCTION:	batch_reap()
+ * ARGUMENTS:	Pointer to batch state.
+ * RETURNS:	Nothing.
+ * DESCRIPTION: Function to wait for oldest running batch to finish.
+ * 		Only children started by this batch are waited for, as
+ * 		other pipeline stages may be running at the same time.
+ *====================================================================*/
+static void batch_reap(Batch *batch)
+{
+	int child_status;
+	pid_t child_pid = batch->pids[batch->reaped++ % batch->jobs];
+
+	if(waitpid(child_pid, &child_status, 0) > 0)
+	{
+		TRACE(TRACE_EXIT, PHASE_INSTANT, child_status);
+
+		if(WIFEXITED(child_status) && WEXITSTATUS(child_status) != 0)
+			fprintf(stderr, "batch: %s: exited with status %d.\n",
+					batch->argv[0], WEXITSTATUS(child_status));
+	}
+
+	batch->running--;
+
+} // End of 'batch_reap()'.
+
+
+
+/*======================================================================
+ * FUNCTION:	batch_launch()
+ * ARGUMENTS:	Pointer to batch state.
+ * RETURNS:	Operation success or failure.
+ * DESCRIPTION: Function to run command with arguments gathered so far
+ * 		as a child process, then empty batch for further items.
+ * 		If the maximum number of batches are already running,
+ * 		wait for one to finish first.
+ * 		If items are read from stdin, child reads /dev/null
+ * 		instead, as xargs does, so it cannot consume them.
+ *====================================================================*/
+static Operation batch_launch(Batch *batch)
+{
+	pid_t child_pid;
+	int null_fd;
+	int i;
+
+	// Nothing to run if no items gathered.
+	if(batch->count == batch->prefix)
+		return SUCCESS;
+
+	while(batch->running >= batch->jobs)
+		batch_reap(batch);
+
+	child_pid = traced_fork();
+
+	if(child_pid == -1)
+	{
+		perror("batch: fork()");
+		return FAILURE;
+	}
+
+	// In child process:
+	if(child_pid == 0)
+	{
+		if(batch->items_on_stdin && (null_fd = open("/dev/null", O_RDONLY)) != -1)
+			dup2(null_fd, STDIN_FD);
+
+		builtin_child_fds();
+		child_exec(batch->argv);
+	}
+
+	batch->pids[batch->launched % batch->jobs] = child_pid;
+	batch->running++;
+	batch->launched++;
+
+	// Child has its own copy of items, so free them here.
+	for(i = batch->prefix; i < batch->count; i++)
+		free(batch->argv[i]);
+
+	batch->count = batch->prefix;
+	batch->argv[batch->count] = NULL;
+	batch->used = 0;
+
+	return SUCCESS;
+
+} // End of 'batch_launch()'.
+
+
+
+/*======================================================================
+ * FUNCTION:	batch_add()
+ * ARGUMENTS:	batch: Pointer to batch state.
+ * 		item:  Argument to add to batch.
+ * RETURNS:	Operation success or failure.
+ * DESCRIPTION: Function to append an item to current batch.
+ * 		If item would not fit in space left by ARG_MAX,
+ * 		current batch is launched first.
+ *====================================================================*/
+static Operation batch_add(Batch *batch, const char *item)
+{
+	long size = strlen(item) + 1 + sizeof(char*);
+
+	if(size > batch->limit)
+	{
+		fprintf(stderr, "batch: Argument too long, skipped.\n");
+		return SUCCESS;
+	}
+
+	if(batch->used + size > batch->limit)
+		if(batch_launch(batch) == FAILURE)
+			return FAILURE;
+
+	// Grow argv, leaving room for final NULL pointer.
+	if(batch->count + 1 >= batch->capacity)
+	{
+		char **grown;
+
+		if((grown = realloc(batch->argv, 2 * batch->capacity * sizeof(char*))) == NULL)
+		{
+			fprintf(stderr, "batch: realloc: Failed to reallocate memory.\n");
+			return FAILURE;
+		}
+		batch->argv = grown;
+		batch->capacity *= 2;
+	}
+
+	if((batch->argv[batch->count] = strdup(item)) == NULL)
+	{
+		fprintf(stderr, "batch: strdup: Failed to allocate memory.\n");
+		return FAILURE;
+	}
+
+	batch->argv[++batch->count] = NULL;
+	batch->used += size;
+
+	return SUCCESS;
+
+} // End of 'batch_add()'.
+
+
+
+/*======================================================================
+ * FUNCTION:	batch_command()
+ * ARGUMENTS:	Command line parsed into strings for each argument.
+ * RETURNS:	Boolean true when user has called 'batch'.
+ * 		Boolean false when user has not.
+ * DESCRIPTION: Function to run a command over many items when builtin
+ * 		command 'batch' called.
+ * 		Options are:
+ * 			-P jobs:	Run up to 'jobs' batches at once.
+ * 			-g pattern:	Take items from glob pattern
+ * 					instead of stdin. May be repeated.
+ * 		Remaining arguments are used as the fixed prefix of every
+ * 		batch. Items are read from stdin one per line unless a
+ * 		glob pattern is given.
+ *====================================================================*/
+Boolean batch_command(char** cmd_line)
+{
+	Batch batch;
+	glob_t matches;
+	Boolean use_glob = FALSE;
+	Operation status = SUCCESS;
+	char *line = NULL;
+	size_t line_size = 0;
+	ssize_t length;
+	size_t n;
+	int i = 1;
+	int prefix;
+
+	// If user has not called 'batch':
+	if(strcmp(cmd_line[0],"batch") != 0)
+		return FALSE;
+
+	memset(&batch, 0, sizeof(Batch));
+	batch.jobs = 1;
+
+	// Read options before command prefix.
+	while(cmd_line[i] != NULL && cmd_line[i][0] == '-')
+	{
+		if(strcmp(cmd_line[i],"-P") == 0 && cmd_line[i+1] != NULL)
+		{
+			if((batch.jobs = atoi(cmd_line[i+1])) < 1)
+				batch.jobs = 1;
+		}
+		else if(strcmp(cmd_line[i],"-g") == 0 && cmd_line[i+1] != NULL)
+		{
+			if(glob(cmd_line[i+1], use_glob ? GLOB_APPEND : 0, NULL, &matches) == GLOB_NOSPACE)
+			{
+				fprintf(stderr, "batch: glob: Failed to allocate memory.\n");
+				globfree(&matches);
+				return TRUE;
+			}
+			use_glob = TRUE;
+		}
+		else
+		{
+			fprintf(stderr, "batch: Unknown option '%s'. Try 'help batch'.\n", cmd_line[i]);
+			if(use_glob) globfree(&matches);
+			return TRUE;
+		}
+		i += 2;
+	}
+
+	if(cmd_line[i] == NULL)
+	{
+		fprintf(stderr, "batch: No command given. Try 'help batch'.\n");
+		if(use_glob) globfree(&matches);
+		return TRUE;
+	}
+
+	if((batch.pids = malloc(batch.jobs * sizeof(pid_t))) == NULL)
+	{
+		fprintf(stderr, "batch: malloc: Failed to allocate memory.\n");
+		if(use_glob) globfree(&matches);
+		return TRUE;
+	}
+
+	// Copy command prefix from parsed command line.
+	for(prefix = i; cmd_line[prefix] != NULL; prefix++);
+	batch.prefix = batch.count = prefix - i;
+	batch.capacity = batch.prefix + 64;
+
+	if((batch.argv = malloc(batch.capacity * sizeof(char*))) == NULL)
+	{
+		fprintf(stderr, "batch: malloc: Failed to allocate memory.\n");
+		if(use_glob) globfree(&matches);
+		free(batch.pids);
+		return TRUE;
+	}
+
+	batch.limit = batch_limit();
+	for(prefix = 0; prefix < batch.prefix; prefix++)
+	{
+		batch.argv[prefix] = cmd_line[i + prefix];
+		batch.limit -= strlen(cmd_line[i + prefix]) + 1 + sizeof(char*);
+	}
+	batch.argv[batch.count] = NULL;
+
+	catch_parent_signals("batch");
+
+	batch.items_on_stdin = !use_glob;
+
+	// Gather items and launch batches as they fill up.
+	if(use_glob)
+	{
+		for(n = 0; n < matches.gl_pathc && status == SUCCESS; n++)
+			status = batch_add(&batch, matches.gl_pathv[n]);
+		globfree(&matches);
+	}
+	else
+	{
+		while(status == SUCCESS && (length = getline(&line, &line_size, BUILTIN_IN)) != -1)
+		{
+			if(length > 0 && line[length - 1] == '\n')
+				line[--length] = '\0';
+			if(length > 0)
+				status = batch_add(&batch, line);
+		}
+		free(line);
+
+		// Allow shell to keep reading commands after EOF ended item list.
+		clearerr(BUILTIN_IN);
+	}
+
+	if(status == SUCCESS)
+		batch_launch(&batch);
+
+	while(batch.running > 0)
+		batch_reap(&batch);
+
+	for(prefix = batch.prefix; prefix < batch.count; prefix++)
+		free(batch.argv[prefix]);
+	free(batch.argv);
+	free(batch.pids);
+
+	return TRUE;
+
+} // End of 'batch_command()'.
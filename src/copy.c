@@ -0,0 +1,579 @@
+/*======================================================================
+
+	University College Dublin
+	COMP20200 - UNIX Programming
+
+	Assignment 2: 	Implement a simple shell
+
+	Project:	assign2_19351611
+	File Name:   	copy.c
+	Description: 	Simple UNIX shell program.
+			Reads line from stdin and executes command.
+			This file contains the builtin commands 'cat', 'cp'
+			and 'tee', which copy data within the shell process
+			rather than forking an external program.
+			Data is moved inside the kernel with
+			copy_file_range(), splice() or sendfile() where the
+			file descriptor types allow it, falling back to a
+			read()/write() loop on a large aligned buffer.
+			Every copy stops at the next interrupt signal.
+
+			These include:
+				> copy_catch_interrupts()
+				> copy_interrupted()
+				> copy_continue()
+				> copy_fallback()
+				> copy_fd()
+				> cat_command()
+				> cp_command()
+				> tee_command()
+
+	Author:      	Cian O'Mahoney
+	Student Number:	19351611
+	Email:		cian.omahoney@ucdconnect.ie
+	Date:        	15/2/2021
+	Version:     	1.0
+
+======================================================================*/
+
+
+
+/*======================================================================
+Systems header files
+======================================================================*/
+#define _GNU_SOURCE	// For copy_file_range(), splice(), tee()
+
+#include <config.h>
+#include "header.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>	// For strcmp(), strrchr()
+#include <limits.h>	// For PATH_MAX
+#include <unistd.h>	// For read(), write(), close(), copy_file_range()
+#include <fcntl.h>	// For open(), splice(), tee()
+#include <errno.h>	// For perror(), errno
+#include <signal.h>	// For sigaction()
+#include <sys/stat.h>	// For fstat(), S_ISREG(), S_ISFIFO()
+#include <sys/ioctl.h>	// For ioctl()
+#include <sys/sendfile.h>// For sendfile()
+#include <linux/fs.h>	// For FICLONE
+
+
+
+static __thread sig_atomic_t copy_interrupts;	// Interrupt count when copy began.
+
+
+
+/*======================================================================
+ * FUNCTION:	copy_catch_interrupts()
+ * ARGUMENTS:	None.
+ * RETURNS:	Nothing.
+ * DESCRIPTION: Function to note the interrupts received so far, so a
+ * 		copy can stop at the next one.
+ * 		Run by the shell itself, parent_sig_handler() is set
+ * 		without SA_RESTART, so an interrupt also ends a read()
+ * 		or write() blocked on a terminal or pipe. A pipeline
+ * 		stage keeps the handler pipeline() set and notices the
+ * 		count change between chunks.
+ *====================================================================*/
+static void copy_catch_interrupts(void)
+{
+	struct sigaction action;
+
+	copy_interrupts = interrupt_count;
+
+	if(builtin_in != NULL || builtin_out != NULL)
+		return;
+
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = parent_sig_handler;
+	sigemptyset(&action.sa_mask);
+	if(sigaction(SIGINT, &action, NULL) == -1)
+		perror("copy_catch_interrupts(): sigaction()");
+
+} // End of 'copy_catch_interrupts()'.
+
+
+
+/*======================================================================
+ * FUNCTION:	copy_interrupted()
+ * ARGUMENTS:	None.
+ * RETURNS:	Boolean true when interrupted since copy began.
+ * 		Boolean false when not.
+ * DESCRIPTION: Function to check for an interrupt since
+ * 		copy_catch_interrupts() was called.
+ *====================================================================*/
+static Boolean copy_interrupted(void)
+{
+	return interrupt_count != copy_interrupts;
+
+} // End of 'copy_interrupted()'.
+
+
+
+/*======================================================================
+ * FUNCTION:	copy_continue()
+ * ARGUMENTS:	Bytes moved by last kernel copy, or -1 on error.
+ * RETURNS:	Boolean true when copy should carry on.
+ * 		Boolean false when finished, failed or interrupted.
+ * DESCRIPTION: Function to decide whether a kernel copy loop should
+ * 		go round again. A call cut short by a signal other
+ * 		than an interrupt is retried.
+ *====================================================================*/
+static Boolean copy_continue(ssize_t length)
+{
+	if(copy_interrupted())
+		return FALSE;
+
+	return (length > 0 || (length == -1 && errno == EINTR));
+
+} // End of 'copy_continue()'.
+
+
+/*======================================================================
+ * FUNCTION:	copy_fallback()
+ * ARGUMENTS:	in_fd:  File descriptor to read from.
+ * 		out_fd: File descriptor to write to.
+ * RETURNS:	Operation success or failure.
+ * DESCRIPTION: Function to copy until end of file using read() and
+ * 		write() on a page aligned buffer, for descriptors the
+ * 		kernel cannot copy between directly.
+ * 		Fails with errno EINTR when interrupted.
+ *====================================================================*/
+static Operation copy_fallback(int in_fd, int out_fd)
+{
+	void *buffer;
+	ssize_t length, written, offset;
+
+	if(posix_memalign(&buffer, sysconf(_SC_PAGESIZE), COPY_BUFFER_SIZE) != 0)
+	{
+		fprintf(stderr, "copy_fallback(): posix_memalign: Failed to allocate memory.\n");
+		return FAILURE;
+	}
+
+	while(!copy_interrupted() && (length = read(in_fd, buffer, COPY_BUFFER_SIZE)) != 0)
+	{
+		if(length == -1)
+		{
+			if(errno == EINTR)
+				continue;
+			free(buffer);
+			return FAILURE;
+		}
+
+		for(offset = 0; offset < length && !copy_interrupted(); offset += written)
+			if((written = write(out_fd, (char *)buffer + offset, length - offset)) == -1)
+			{
+				if(errno == EINTR)
+				{
+					written = 0;
+					continue;
+				}
+				free(buffer);
+				return FAILURE;
+			}
+	}
+
+	free(buffer);
+
+	if(copy_interrupted())
+	{
+		errno = EINTR;
+		return FAILURE;
+	}
+
+	return SUCCESS;
+
+} // End of 'copy_fallback()'.
+
+
+
+/*======================================================================
+ * FUNCTION:	copy_fd()
+ * ARGUMENTS:	in_fd:  File descriptor to read from.
+ * 		out_fd: File descriptor to write to.
+ * RETURNS:	Operation success or failure.
+ * DESCRIPTION: Function to copy until end of file, choosing the
+ * 		cheapest method the descriptor types allow:
+ * 			File to file:	copy_file_range()
+ * 			Either a pipe:	splice()
+ * 			From a file:	sendfile()
+ * 		Each method advances the file offsets, so if one stops
+ * 		part way with an unsupported error, the next method
+ * 		carries on from where it left off.
+ * 		Fails with errno EINTR when interrupted.
+ *====================================================================*/
+static Operation copy_fd(int in_fd, int out_fd)
+{
+	struct stat in_stat, out_stat;
+	ssize_t length;
+
+	if(fstat(in_fd, &in_stat) == -1 || fstat(out_fd, &out_stat) == -1)
+		return FAILURE;
+
+	if(S_ISREG(in_stat.st_mode) && S_ISREG(out_stat.st_mode))
+	{
+		while(copy_continue(length = copy_file_range(in_fd, NULL, out_fd, NULL, COPY_CHUNK_SIZE, 0)));
+		if(copy_interrupted())
+		{
+			errno = EINTR;
+			return FAILURE;
+		}
+		if(length == 0)
+			return SUCCESS;
+		if(errno != EXDEV && errno != EINVAL && errno != ENOSYS && errno != EBADF && errno != EOPNOTSUPP)
+			return FAILURE;
+	}
+
+	if(S_ISFIFO(in_stat.st_mode) || S_ISFIFO(out_stat.st_mode))
+	{
+		while(copy_continue(length = splice(in_fd, NULL, out_fd, NULL, COPY_CHUNK_SIZE, SPLICE_F_MOVE | SPLICE_F_MORE)));
+		if(copy_interrupted())
+		{
+			errno = EINTR;
+			return FAILURE;
+		}
+		if(length == 0)
+			return SUCCESS;
+		if(errno != EINVAL && errno != ENOSYS)
+			return FAILURE;
+	}
+
+	if(S_ISREG(in_stat.st_mode))
+	{
+		while(copy_continue(length = sendfile(out_fd, in_fd, NULL, COPY_CHUNK_SIZE)));
+		if(copy_interrupted())
+		{
+			errno = EINTR;
+			return FAILURE;
+		}
+		if(length == 0)
+			return SUCCESS;
+		if(errno != EINVAL && errno != ENOSYS)
+			return FAILURE;
+	}
+
+	return copy_fallback(in_fd, out_fd);
+
+} // End of 'copy_fd()'.
+
+
+
+/*======================================================================
+ * FUNCTION:	cat_command()
+ * ARGUMENTS:	Command line parsed into strings for each argument.
+ * RETURNS:	Boolean true when user has called 'cat'.
+ * 		Boolean false when user has not.
+ * DESCRIPTION: Function to write each file named, or stdin if none
+ * 		or '-' given, to stdout when builtin command 'cat' called.
+ *====================================================================*/
+Boolean cat_command(char** cmd_line)
+{
+	int out_fd;
+	int in_fd;
+	int i = 1;
+
+	// If user has not called 'cat':
+	if(strcmp(cmd_line[0],"cat") != 0)
+		return FALSE;
+
+	copy_catch_interrupts();
+
+	// Anything already printed must reach stdout before copied data.
+	fflush(BUILTIN_OUT);
+	out_fd = fileno(BUILTIN_OUT);
+
+	do
+	{
+		if(cmd_line[i] == NULL || strcmp(cmd_line[i],"-") == 0)
+			in_fd = fileno(BUILTIN_IN);
+		else if((in_fd = open(cmd_line[i], O_RDONLY | O_CLOEXEC)) == -1)
+		{
+			fprintf(stderr, "cat: %s: ", cmd_line[i]);
+			perror(NULL);
+			continue;
+		}
+
+		if(copy_fd(in_fd, out_fd) == FAILURE && errno != EPIPE && errno != EINTR)
+		{
+			fprintf(stderr, "cat: %s: ", cmd_line[i] != NULL ? cmd_line[i] : "-");
+			perror(NULL);
+		}
+
+		if(in_fd != fileno(BUILTIN_IN))
+			close(in_fd);
+	}
+	while(!copy_interrupted() && cmd_line[i] != NULL && cmd_line[++i] != NULL);
+
+	return TRUE;
+
+} // End of 'cat_command()'.
+
+
+
+/*======================================================================
+ * FUNCTION:	cp_command()
+ * ARGUMENTS:	Command line parsed into strings for each argument.
+ * RETURNS:	Boolean true when user has called 'cp'.
+ * 		Boolean false when user has not.
+ * DESCRIPTION: Function to copy files when builtin command 'cp' called.
+ * 		If destination is a directory, each source is copied into
+ * 		it under the same name. Files are first cloned with
+ * 		FICLONE, which shares blocks on filesystems with reflink
+ * 		support, and otherwise copied with copy_fd().
+ *====================================================================*/
+Boolean cp_command(char** cmd_line)
+{
+	struct stat in_stat, out_stat;
+	char path[PATH_MAX];
+	char *destination;
+	int length;
+	char *name;
+	Boolean directory;
+	int in_fd, out_fd;
+	int count, i;
+
+	// If user has not called 'cp':
+	if(strcmp(cmd_line[0],"cp") != 0)
+		return FALSE;
+
+	copy_catch_interrupts();
+
+	for(count = 1; cmd_line[count] != NULL; count++);
+
+	if(count < 3)
+	{
+		fprintf(stderr, "cp: Missing file operand. Try 'help cp'.\n");
+		return TRUE;
+	}
+
+	destination = cmd_line[count - 1];
+	directory = (stat(destination, &out_stat) == 0 && S_ISDIR(out_stat.st_mode));
+
+	if(count > 3 && !directory)
+	{
+		fprintf(stderr, "cp: Target '%s' is not a directory.\n", destination);
+		return TRUE;
+	}
+
+	for(i = 1; i < count - 1 && !copy_interrupted(); i++)
+	{
+		if((in_fd = open(cmd_line[i], O_RDONLY | O_CLOEXEC)) == -1 || fstat(in_fd, &in_stat) == -1)
+		{
+			fprintf(stderr, "cp: %s: ", cmd_line[i]);
+			perror(NULL);
+			if(in_fd != -1) close(in_fd);
+			continue;
+		}
+
+		if(S_ISDIR(in_stat.st_mode))
+		{
+			fprintf(stderr, "cp: %s: Is a directory, skipped.\n", cmd_line[i]);
+			close(in_fd);
+			continue;
+		}
+
+		// Copy into directory under same name as source.
+		if(directory)
+		{
+			name = ((name = strrchr(cmd_line[i], '/')) != NULL) ? name + 1 : cmd_line[i];
+			length = snprintf(path, sizeof(path), "%s/%s", destination, name);
+		}
+		else
+			length = snprintf(path, sizeof(path), "%s", destination);
+
+		// A shortened path would name a different file to truncate.
+		if(length < 0 || length >= (int)sizeof(path))
+		{
+			fprintf(stderr, "cp: %s: File name too long.\n", destination);
+			close(in_fd);
+			continue;
+		}
+
+		// Opening destination truncates it, so refuse to copy a file onto itself.
+		if(stat(path, &out_stat) == 0 && out_stat.st_dev == in_stat.st_dev && out_stat.st_ino == in_stat.st_ino)
+		{
+			fprintf(stderr, "cp: '%s' and '%s' are the same file.\n", cmd_line[i], path);
+			close(in_fd);
+			continue;
+		}
+
+		if((out_fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, in_stat.st_mode & 0777)) == -1)
+		{
+			fprintf(stderr, "cp: %s: ", path);
+			perror(NULL);
+			close(in_fd);
+			continue;
+		}
+
+#ifdef FICLONE
+		if(ioctl(out_fd, FICLONE, in_fd) == 0)
+		{
+			close(in_fd);
+			close(out_fd);
+			continue;
+		}
+#endif
+
+		if(copy_fd(in_fd, out_fd) == FAILURE && errno != EINTR)
+		{
+			fprintf(stderr, "cp: %s: ", path);
+			perror(NULL);
+		}
+
+		close(in_fd);
+		close(out_fd);
+	}
+
+	return TRUE;
+
+} // End of 'cp_command()'.
+
+
+
+/*======================================================================
+ * FUNCTION:	tee_command()
+ * ARGUMENTS:	Command line parsed into strings for each argument.
+ * RETURNS:	Boolean true when user has called 'tee'.
+ * 		Boolean false when user has not.
+ * DESCRIPTION: Function to copy stdin to stdout and to each file named
+ * 		when builtin command 'tee' called. Option '-a' appends
+ * 		to files rather than truncating them.
+ * 		When stdin and stdout are both pipes and a single file is
+ * 		named without '-a', tee() duplicates data into stdout and
+ * 		splice() moves it into the file, so it never enters the
+ * 		shell. If either fails, copying carries on through the
+ * 		buffer, so the file still receives everything.
+ *====================================================================*/
+Boolean tee_command(char** cmd_line)
+{
+	struct stat in_stat, out_stat;
+	int fds[TEE_MAX_FILES + 1];
+	char *names[TEE_MAX_FILES + 1];
+	int open_count;
+	int flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+	int count = 1;
+	int in_fd, i, j, first;
+	void *buffer = NULL;
+	ssize_t length, written, offset;
+	ssize_t pending = 0;
+	Boolean copied = FALSE;
+
+	// If user has not called 'tee':
+	if(strcmp(cmd_line[0],"tee") != 0)
+		return FALSE;
+
+	copy_catch_interrupts();
+
+	i = 1;
+	if(cmd_line[i] != NULL && strcmp(cmd_line[i],"-a") == 0)
+	{
+		flags = O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC;
+		i++;
+	}
+
+	fflush(BUILTIN_OUT);
+	fds[0] = fileno(BUILTIN_OUT);
+	names[0] = "stdout";
+	in_fd = fileno(BUILTIN_IN);
+
+	for(; cmd_line[i] != NULL; i++)
+	{
+		if(count > TEE_MAX_FILES)
+		{
+			fprintf(stderr, "tee: Too many files, '%s' skipped.\n", cmd_line[i]);
+			continue;
+		}
+		if((fds[count] = open(cmd_line[i], flags, 0666)) == -1)
+		{
+			fprintf(stderr, "tee: %s: ", cmd_line[i]);
+			perror(NULL);
+			continue;
+		}
+		names[count++] = cmd_line[i];
+	}
+
+	// Zero copy: duplicate pipe into stdout, then move it into the file.
+	// splice() cannot write to a file opened for appending.
+	if(count == 2 && !(flags & O_APPEND) && fstat(in_fd, &in_stat) == 0 && fstat(fds[0], &out_stat) == 0 &&
+			S_ISFIFO(in_stat.st_mode) && S_ISFIFO(out_stat.st_mode))
+	{
+		while(pending == 0 && copy_continue(length = tee(in_fd, fds[0], COPY_CHUNK_SIZE, 0)))
+			for(offset = 0; offset < length; offset += written)
+				if((written = splice(in_fd, NULL, fds[1], NULL, length - offset, SPLICE_F_MOVE)) <= 0)
+				{
+					// Bytes already in stdout are copied to the file alone.
+					pending = length - offset;
+					break;
+				}
+
+		if(pending > 0)
+			copied = FALSE;
+		else if(length == -1 && !copy_interrupted() && errno != EINVAL && errno != ENOSYS)
+		{
+			// Stdout failed, so carry on writing to the file alone.
+			fprintf(stderr, "tee: %s: ", names[0]);
+			perror(NULL);
+			fds[0] = -1;
+		}
+		else
+			copied = (length == 0 || copy_interrupted());
+	}
+
+	if(!copied)
+	{
+		if(posix_memalign(&buffer, sysconf(_SC_PAGESIZE), COPY_BUFFER_SIZE) != 0)
+			fprintf(stderr, "tee: posix_memalign: Failed to allocate memory.\n");
+		else
+		{
+			// Stop writing to an output once it fails, and stop reading once all have.
+			for(open_count = 0, j = 0; j < count; j++)
+				if(fds[j] != -1)
+					open_count++;
+
+			while(open_count > 0 && !copy_interrupted() &&
+					(length = read(in_fd, buffer, (pending > 0 && pending < COPY_BUFFER_SIZE) ? pending : COPY_BUFFER_SIZE)) != 0)
+			{
+				if(length == -1)
+				{
+					if(errno == EINTR)
+						continue;
+					perror("tee: read()");
+					break;
+				}
+
+				// Skip stdout for bytes tee() already duplicated into it.
+				first = (pending > 0);
+				if(pending > 0)
+					pending -= length;
+
+				for(j = first; j < count; j++)
+					for(offset = 0; fds[j] != -1 && offset < length && !copy_interrupted(); offset += written)
+						if((written = write(fds[j], (char *)buffer + offset, length - offset)) == -1)
+						{
+							if(errno == EINTR)
+							{
+								written = 0;
+								continue;
+							}
+							fprintf(stderr, "tee: %s: ", names[j]);
+							perror(NULL);
+							if(j > 0)
+								close(fds[j]);
+							fds[j] = -1;
+							open_count--;
+						}
+			}
+
+			free(buffer);
+		}
+	}
+
+	for(j = 1; j < count; j++)
+		if(fds[j] != -1)
+			close(fds[j]);
+
+	return TRUE;
+
+} // End of 'tee_command()'.
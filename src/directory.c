@@ -0,0 +1,990 @@
+/*======================================================================
+
+	University College Dublin
+	COMP20200 - UNIX Programming
+
+	Assignment 2: 	Implement a simple shell
+
+	Project:	assign2_19351611
+	File Name:   	directory.c
+	Description: 	Simple UNIX shell program.
+			Reads line from stdin and executes command.
+			This file contains the functions used to change
+			directory and to remember directories visited.
+			Every successful change of directory is recorded
+			in a memory-mapped index file in the user's home
+			directory, scored by frequency and recency, which
+			builtin command 'z' searches to jump to a directory
+			by part of its name.
+			Each shell keeps a hash table of paths in the file,
+			and lists of the paths holding each trigram of
+			lowercase characters, so neither recording a visit
+			nor searching has to read every record.
+			Builtin commands 'pushd', 'popd' and 'dirs' keep a
+			stack of directories.
+
+			These include:
+				> dirindex_map()
+				> dirindex_check()
+				> dirindex_open()
+				> dirindex_mask()
+				> dirindex_hash()
+				> dirindex_trigram()
+				> dirindex_post()
+				> dirindex_insert()
+				> dirindex_sync()
+				> dirindex_find()
+				> dirindex_age()
+				> dirindex_add()
+				> dirindex_score()
+				> dirindex_match()
+				> change_to()
+				> z_command()
+				> pushd_command()
+				> popd_command()
+				> dirs_command()
+
+	Author:      	Cian O'Mahoney
+	Student Number:	19351611
+	Email:		cian.omahoney@ucdconnect.ie
+	Date:        	15/2/2021
+	Version:     	1.0
+
+======================================================================*/
+
+
+
+/*======================================================================
+Systems header files
+======================================================================*/
+#include <config.h>
+#include "header.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>	// For uint64_t, uint32_t, uint16_t
+#include <stddef.h>	// For offsetof()
+#include <string.h>	// For strcmp(), strlen(), strstr(), memcpy(), memmove()
+#include <limits.h>	// For PATH_MAX
+#include <ctype.h>	// For tolower()
+#include <time.h>	// For time()
+#include <unistd.h>	// For chdir(), getcwd(), ftruncate(), close()
+#include <fcntl.h>	// For open()
+#include <errno.h>	// For perror(), errno
+#include <pthread.h>	// For pthread_mutex_lock()
+#include <sys/file.h>	// For flock()
+#include <sys/mman.h>	// For mmap(), munmap()
+#include <sys/stat.h>	// For fstat()
+
+
+
+/*======================================================================
+ Index file layout
+ 	Header is followed by variable sized records, each holding the
+ 	path and a lowercase copy of it, padded to a multiple of 8 bytes.
+======================================================================*/
+typedef struct
+{
+	uint32_t magic;		// DIRINDEX_MAGIC if file is an index.
+	uint32_t count;		// Number of records.
+	uint64_t used;		// Bytes used, including header.
+	double total_rank;	// Sum of rank of every record.
+	uint64_t generation;	// Changed whenever records are moved.
+} Dir_header;
+
+typedef struct
+{
+	uint64_t mask;		// Character pairs present in lowercase path.
+	int64_t last;		// Time of last visit.
+	double rank;		// Number of visits, reduced as index ages.
+	uint32_t hash;		// Hash of path, to find record quickly.
+	uint16_t length;	// Length of path.
+	uint16_t base;		// Offset of last component within path.
+	uint32_t size;		// Size of record in bytes.
+	uint32_t padding;
+	char text[];		// Path, then lowercase path, NUL terminated.
+} Dir_record;
+
+typedef struct
+{
+	uint32_t *offsets;	// Offsets of records holding trigram, ascending.
+	uint32_t count;		// Offsets in list.
+	uint32_t capacity;	// Offsets allocated.
+} Dir_posting;
+
+
+static int index_fd = -1;			// Open index file.
+static char *index_map = NULL;			// Mapping of index file.
+static size_t index_size = 0;			// Size of mapping.
+static pthread_mutex_t index_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static uint32_t *path_table = NULL;		// Record offsets by hash of path, 0 if empty.
+static uint32_t path_table_size = 0;		// Slots in table, a power of two.
+static uint32_t path_table_count = 0;		// Slots in use.
+static Dir_posting *postings = NULL;		// Records by trigram, built by first 'z'.
+static uint64_t indexed_used = 0;		// Bytes of index file in tables.
+static uint64_t indexed_generation = 0;		// Generation of index file in tables.
+
+Boolean record_visits = TRUE;			// Cleared in pipeline children.
+
+static char *dir_stack[DIRSTACK_SIZE];		// Directories saved by 'pushd'.
+static int dir_stack_count = 0;
+
+#define HEADER ((Dir_header *)index_map)
+#define RECORD(offset) ((Dir_record *)(index_map + (offset)))
+
+
+
+/*======================================================================
+ * FUNCTION:	dirindex_map()
+ * ARGUMENTS:	Smallest size mapping must cover.
+ * RETURNS:	Operation success or failure.
+ * DESCRIPTION: Function to make sure index file is mapped in full.
+ * 		File is grown if smaller than size wanted, and remapped
+ * 		if it was grown, here or by another shell.
+ *====================================================================*/
+static Operation dirindex_map(size_t wanted)
+{
+	struct stat file_stat;
+	size_t size;
+
+	if(fstat(index_fd, &file_stat) == -1)
+		return FAILURE;
+
+	size = file_stat.st_size;
+
+	if(size < wanted)
+	{
+		for(size = (size < DIRINDEX_INITIAL_SIZE) ? DIRINDEX_INITIAL_SIZE : size; size < wanted; size *= 2);
+
+		if(ftruncate(index_fd, size) == -1)
+		{
+			perror("dirindex_map(): ftruncate()");
+			return FAILURE;
+		}
+	}
+
+	if(index_map != NULL && size == index_size)
+		return SUCCESS;
+
+	if(index_map != NULL)
+		munmap(index_map, index_size);
+
+	if((index_map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, index_fd, 0)) == MAP_FAILED)
+	{
+		perror("dirindex_map(): mmap()");
+		index_map = NULL;
+		index_size = 0;
+		return FAILURE;
+	}
+
+	index_size = size;
+
+	return SUCCESS;
+
+} // End of 'dirindex_map()'.
+
+
+
+/*======================================================================
+ * FUNCTION:	dirindex_check()
+ * ARGUMENTS:	None.
+ * RETURNS:	Operation success, or failure if index is damaged.
+ * DESCRIPTION: Function to check every record lies within index,
+ * 		so later walks of index cannot run off its end.
+ *====================================================================*/
+static Operation dirindex_check(void)
+{
+	uint64_t offset;
+	Dir_record *record;
+
+	if(HEADER->used < sizeof(Dir_header) || HEADER->used > index_size)
+		return FAILURE;
+
+	for(offset = sizeof(Dir_header); offset < HEADER->used; offset += record->size)
+	{
+		record = RECORD(offset);
+		if(offset + sizeof(Dir_record) > HEADER->used || record->size < sizeof(Dir_record) ||
+				offset + record->size > HEADER->used || record->base > record->length)
+			return FAILURE;
+	}
+
+	return SUCCESS;
+
+} // End of 'dirindex_check()'.
+
+
+
+/*======================================================================
+ * FUNCTION:	dirindex_open()
+ * ARGUMENTS:	None.
+ * RETURNS:	Operation success or failure.
+ * DESCRIPTION: Function to open and map index file in home directory,
+ * 		creating it if it does not exist yet.
+ * 		Called with index_lock held.
+ *====================================================================*/
+static Operation dirindex_open(void)
+{
+	char path[PATH_MAX];
+	char *home;
+	int length;
+
+	if(index_fd != -1)
+		return dirindex_map(0);
+
+	if((home = getenv("HOME")) == NULL)
+		return FAILURE;
+
+	// A shortened path would name a different file.
+	length = snprintf(path, sizeof(path), "%s/.%s_dirs", home, PACKAGE);
+	if(length < 0 || length >= (int)sizeof(path))
+		return FAILURE;
+
+	if((index_fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0600)) == -1)
+		return FAILURE;
+
+	flock(index_fd, LOCK_EX);
+
+	if(dirindex_map(sizeof(Dir_header)) == FAILURE)
+	{
+		flock(index_fd, LOCK_UN);
+		close(index_fd);
+		index_fd = -1;
+		return FAILURE;
+	}
+
+	// New or unrecognised file, start an empty index.
+	if(HEADER->magic != DIRINDEX_MAGIC || dirindex_check() == FAILURE)
+	{
+		memset(HEADER, 0, sizeof(Dir_header));
+		HEADER->magic = DIRINDEX_MAGIC;
+		HEADER->used = sizeof(Dir_header);
+	}
+
+	flock(index_fd, LOCK_UN);
+
+	return SUCCESS;
+
+} // End of 'dirindex_open()'.
+
+
+
+/*======================================================================
+ * FUNCTION:	dirindex_mask()
+ * ARGUMENTS:	Lowercase string.
+ * RETURNS:	Bit mask of pairs of adjacent characters in string.
+ * DESCRIPTION: Function to summarise which character pairs a string
+ * 		contains. A record can only match a pattern if its mask
+ * 		contains every bit of the pattern's mask, which rules out
+ * 		most records with a single AND.
+ *====================================================================*/
+static uint64_t dirindex_mask(const char *text)
+{
+	uint64_t mask = 0;
+
+	for(; text[0] != '\0' && text[1] != '\0'; text++)
+		mask |= 1ULL << (((unsigned char)text[0] * 31 + (unsigned char)text[1]) & 63);
+
+	return mask;
+
+} // End of 'dirindex_mask()'.
+
+
+
+/*======================================================================
+ * FUNCTION:	dirindex_hash()
+ * ARGUMENTS:	Path to hash.
+ * RETURNS:	FNV-1a hash of path.
+ *====================================================================*/
+static uint32_t dirindex_hash(const char *path)
+{
+	uint32_t hash = 2166136261u;
+
+	for(; *path != '\0'; path++)
+		hash = (hash ^ (unsigned char)*path) * 16777619u;
+
+	return hash;
+
+} // End of 'dirindex_hash()'.
+
+
+
+/*======================================================================
+ * FUNCTION:	dirindex_trigram()
+ * ARGUMENTS:	Lowercase string at least three characters long.
+ * RETURNS:	Number of posting list of first three characters.
+ *====================================================================*/
+static uint32_t dirindex_trigram(const char *text)
+{
+	uint32_t trigram = (unsigned char)text[0] << 16 | (unsigned char)text[1] << 8 | (unsigned char)text[2];
+
+	return (trigram * 2654435761u) >> (32 - DIRINDEX_TRIGRAM_BITS);
+
+} // End of 'dirindex_trigram()'.
+
+
+
+/*======================================================================
+ * FUNCTION:	dirindex_post()
+ * ARGUMENTS:	trigram: Posting list to add to.
+ * 		offset:	 Offset of record holding trigram.
+ * RETURNS:	Operation success or failure.
+ * DESCRIPTION: Function to add a record to posting list of a trigram.
+ * 		Records are added in order, so a trigram found twice in
+ * 		one path is only listed once by checking last entry.
+ *====================================================================*/
+static Operation dirindex_post(uint32_t trigram, uint32_t offset)
+{
+	Dir_posting *posting = &postings[trigram];
+	uint32_t *grown;
+	uint32_t capacity;
+
+	if(posting->count > 0 && posting->offsets[posting->count - 1] == offset)
+		return SUCCESS;
+
+	if(posting->count == posting->capacity)
+	{
+		capacity = posting->capacity ? 2 * posting->capacity : 4;
+		if((grown = realloc(posting->offsets, capacity * sizeof(uint32_t))) == NULL)
+			return FAILURE;
+		posting->offsets = grown;
+		posting->capacity = capacity;
+	}
+
+	posting->offsets[posting->count++] = offset;
+
+	return SUCCESS;
+
+} // End of 'dirindex_post()'.
+
+
+
+/*======================================================================
+ * FUNCTION:	dirindex_insert()
+ * ARGUMENTS:	Offset of record to add to tables.
+ * RETURNS:	Operation success or failure.
+ * DESCRIPTION: Function to add a record to path hash table, growing
+ * 		table once half full, and to posting list of every
+ * 		trigram of its lowercase path if they have been built.
+ *====================================================================*/
+static Operation dirindex_insert(uint32_t offset)
+{
+	Dir_record *record = RECORD(offset);
+	const char *lower = &record->text[record->length + 1];
+	uint32_t *grown;
+	uint32_t size, slot, i;
+
+	if(2 * (path_table_count + 1) > path_table_size)
+	{
+		size = path_table_size ? 2 * path_table_size : DIRINDEX_TABLE_SIZE;
+		if((grown = calloc(size, sizeof(uint32_t))) == NULL)
+			return FAILURE;
+
+		for(i = 0; i < path_table_size; i++)
+			if(path_table[i] != 0)
+			{
+				for(slot = RECORD(path_table[i])->hash & (size - 1); grown[slot] != 0; slot = (slot + 1) & (size - 1));
+				grown[slot] = path_table[i];
+			}
+
+		free(path_table);
+		path_table = grown;
+		path_table_size = size;
+	}
+
+	for(slot = record->hash & (path_table_size - 1); path_table[slot] != 0; slot = (slot + 1) & (path_table_size - 1));
+	path_table[slot] = offset;
+	path_table_count++;
+
+	if(postings != NULL)
+		for(i = 0; i + 2 < record->length; i++)
+			if(dirindex_post(dirindex_trigram(&lower[i]), offset) == FAILURE)
+				return FAILURE;
+
+	return SUCCESS;
+
+} // End of 'dirindex_insert()'.
+
+
+
+/*======================================================================
+ * FUNCTION:	dirindex_sync()
+ * ARGUMENTS:	Boolean true if trigram posting lists are needed.
+ * RETURNS:	Operation success, or failure if tables could not be
+ * 		built, in which case callers read every record instead.
+ * DESCRIPTION: Function to bring tables up to date with index file.
+ * 		Records appended since last call, by this or another
+ * 		shell, are added. If records have been moved by aging,
+ * 		tables are emptied and built again.
+ * 		Called with index_lock and file lock held.
+ *====================================================================*/
+static Operation dirindex_sync(Boolean trigrams)
+{
+	Dir_record *record;
+	uint32_t i;
+
+	if(trigrams && postings == NULL)
+	{
+		if((postings = calloc((size_t)1 << DIRINDEX_TRIGRAM_BITS, sizeof(Dir_posting))) == NULL)
+			return FAILURE;
+		indexed_used = 0;
+	}
+
+	// Start again if file has been aged or reset since tables were built.
+	if(indexed_generation != HEADER->generation || indexed_used > HEADER->used || indexed_used == 0)
+	{
+		if(path_table != NULL)
+			memset(path_table, 0, path_table_size * sizeof(uint32_t));
+		path_table_count = 0;
+
+		if(postings != NULL)
+			for(i = 0; i < (1u << DIRINDEX_TRIGRAM_BITS); i++)
+				postings[i].count = 0;
+
+		indexed_generation = HEADER->generation;
+		indexed_used = sizeof(Dir_header);
+	}
+
+	while(indexed_used < HEADER->used)
+	{
+		record = RECORD(indexed_used);
+
+		// Stop at a damaged record, as dirindex_check() would.
+		if(indexed_used + sizeof(Dir_record) > HEADER->used || record->size < sizeof(Dir_record) ||
+				indexed_used + record->size > HEADER->used || record->base > record->length)
+			break;
+
+		if(dirindex_insert(indexed_used) == FAILURE)
+		{
+			fprintf(stderr, "%s: Failed to allocate memory for directory index.\n", PACKAGE);
+			indexed_used = 0;
+			return FAILURE;
+		}
+
+		indexed_used += record->size;
+	}
+
+	return SUCCESS;
+
+} // End of 'dirindex_sync()'.
+
+
+
+/*======================================================================
+ * FUNCTION:	dirindex_find()
+ * ARGUMENTS:	path:	Path to find.
+ * 		hash:	Hash of path.
+ * 		length:	Length of path.
+ * RETURNS:	Pointer to record of path, or NULL if not recorded.
+ * DESCRIPTION: Function to find record of a path by its hash, or by
+ * 		reading every record if tables could not be built.
+ * 		Called with index_lock and file lock held.
+ *====================================================================*/
+static Dir_record *dirindex_find(const char *path, uint32_t hash, size_t length)
+{
+	Dir_record *record;
+	uint64_t offset;
+	uint32_t slot;
+
+	if(dirindex_sync(FALSE) == SUCCESS)
+	{
+		for(slot = hash & (path_table_size - 1); path_table_size > 0 && path_table[slot] != 0;
+				slot = (slot + 1) & (path_table_size - 1))
+		{
+			record = RECORD(path_table[slot]);
+			if(record->hash == hash && record->length == length && strcmp(record->text, path) == 0)
+				return record;
+		}
+
+		return NULL;
+	}
+
+	for(offset = sizeof(Dir_header); offset < HEADER->used; offset += record->size)
+	{
+		record = RECORD(offset);
+		if(record->hash == hash && record->length == length && strcmp(record->text, path) == 0)
+			return record;
+	}
+
+	return NULL;
+
+} // End of 'dirindex_find()'.
+
+
+
+/*======================================================================
+ * FUNCTION:	dirindex_age()
+ * ARGUMENTS:	None.
+ * RETURNS:	Nothing.
+ * DESCRIPTION: Function to reduce rank of every record once total rank
+ * 		passes DIRINDEX_MAX_RANK, so old favourites give way to
+ * 		new ones. Records whose rank falls below one are removed
+ * 		and remaining records moved down to fill the gaps, so
+ * 		generation is changed for every shell to rebuild tables.
+ *====================================================================*/
+static void dirindex_age(void)
+{
+	uint64_t offset, kept = sizeof(Dir_header);
+	Dir_record *record;
+	uint32_t size;
+
+	HEADER->total_rank = 0;
+	HEADER->count = 0;
+
+	for(offset = sizeof(Dir_header); offset < HEADER->used; offset += size)
+	{
+		record = RECORD(offset);
+		size = record->size;
+		record->rank *= DIRINDEX_AGE_FACTOR;
+
+		if(record->rank < 1)
+			continue;
+
+		if(kept != offset)
+			memmove(index_map + kept, record, size);
+
+		HEADER->total_rank += RECORD(kept)->rank;
+		HEADER->count++;
+		kept += size;
+	}
+
+	HEADER->used = kept;
+	HEADER->generation++;
+
+} // End of 'dirindex_age()'.
+
+
+
+/*======================================================================
+ * FUNCTION:	dirindex_add()
+ * ARGUMENTS:	Absolute path of directory visited.
+ * RETURNS:	Nothing.
+ * DESCRIPTION: Function to record a visit to a directory.
+ * 		Rank and time of an existing record are updated in place,
+ * 		otherwise a new record is appended to index.
+ *====================================================================*/
+static void dirindex_add(const char *path)
+{
+	uint32_t hash = dirindex_hash(path);
+	size_t length = strlen(path);
+	size_t size, i;
+	Dir_record *record;
+	const char *base;
+
+	if(length >= DIRINDEX_MAX_PATH)
+		return;
+
+	pthread_mutex_lock(&index_lock);
+
+	if(dirindex_open() == FAILURE)
+	{
+		pthread_mutex_unlock(&index_lock);
+		return;
+	}
+
+	flock(index_fd, LOCK_EX);
+	dirindex_map(0);
+
+	if((record = dirindex_find(path, hash, length)) != NULL)
+	{
+		record->rank += 1;
+		record->last = time(NULL);
+	}
+	else
+	{
+		size = (offsetof(Dir_record, text) + 2 * (length + 1) + 7) & ~(size_t)7;
+
+		// Tables hold offsets in 32 bits, which limits file to 4 GiB.
+		if(HEADER->used + size <= UINT32_MAX && dirindex_map(HEADER->used + size) == SUCCESS)
+		{
+			record = RECORD(HEADER->used);
+			base = strrchr(path, '/');
+
+			record->rank = 1;
+			record->last = time(NULL);
+			record->hash = hash;
+			record->length = length;
+			record->base = (base != NULL && base[1] != '\0') ? base + 1 - path : 0;
+			record->size = size;
+			memcpy(record->text, path, length + 1);
+			for(i = 0; i <= length; i++)
+				record->text[length + 1 + i] = tolower((unsigned char)path[i]);
+			record->mask = dirindex_mask(&record->text[length + 1]);
+
+			HEADER->used += size;
+			HEADER->count++;
+			dirindex_sync(FALSE);
+		}
+	}
+
+	if((HEADER->total_rank += 1) > DIRINDEX_MAX_RANK)
+		dirindex_age();
+
+	flock(index_fd, LOCK_UN);
+	pthread_mutex_unlock(&index_lock);
+
+} // End of 'dirindex_add()'.
+
+
+
+/*======================================================================
+ * FUNCTION:	dirindex_score()
+ * ARGUMENTS:	record: Record to score.
+ * 		now:	Current time.
+ * RETURNS:	Frecency of record.
+ * DESCRIPTION: Function to weight number of visits by how recently
+ * 		directory was last visited.
+ *====================================================================*/
+static double dirindex_score(const Dir_record *record, time_t now)
+{
+	time_t age = now - record->last;
+
+	if(age < 3600)
+		return record->rank * 4;
+	if(age < 86400)
+		return record->rank * 2;
+	if(age < 604800)
+		return record->rank / 2;
+
+	return record->rank / 4;
+
+} // End of 'dirindex_score()'.
+
+
+
+/*======================================================================
+ * FUNCTION:	dirindex_match()
+ * ARGUMENTS:	record:	  Record to test.
+ * 		patterns: Lowercase patterns, NULL terminated.
+ * 		mask:	  Character pairs of all patterns.
+ * RETURNS:	Weight to multiply score of record by:
+ * 		0 if path does not match,
+ * 		DIRINDEX_BASE_WEIGHT if last pattern is in final component,
+ * 		1 otherwise.
+ * DESCRIPTION: Function to test if every pattern appears in path, in
+ * 		order. Comparison is made against the lowercase copy of
+ * 		path, so no case conversion is needed while searching.
+ *====================================================================*/
+static double dirindex_match(const Dir_record *record, char **patterns, uint64_t mask)
+{
+	const char *lower = &record->text[record->length + 1];
+	const char *position = lower;
+	const char *found;
+	int i;
+
+	if((record->mask & mask) != mask)
+		return 0;
+
+	for(i = 0; patterns[i] != NULL; i++)
+	{
+		if((found = strstr(position, patterns[i])) == NULL)
+			return 0;
+
+		// Prefer directories named by last pattern over their subdirectories.
+		if(patterns[i+1] == NULL)
+		{
+			if(found >= lower + record->base)
+				return DIRINDEX_BASE_WEIGHT;
+			if(strstr(lower + record->base, patterns[i]) != NULL)
+				return DIRINDEX_BASE_WEIGHT;
+		}
+
+		position = found + strlen(patterns[i]);
+	}
+
+	return 1;
+
+} // End of 'dirindex_match()'.
+
+
+
+/*======================================================================
+ * FUNCTION:	change_to()
+ * ARGUMENTS:	Path of directory to change to.
+ * RETURNS:	Operation success or failure.
+ * DESCRIPTION: Function to change working directory of shell, set
+ * 		environment variables 'OLDPWD' and 'PWD', and record
+ * 		visit in directory index unless record_visits is cleared.
+ * 		Error is printed by caller.
+ *====================================================================*/
+Operation change_to(char* path)
+{
+	char old_directory[DIRINDEX_MAX_PATH];
+	char new_directory[DIRINDEX_MAX_PATH];
+	Boolean have_old = (getcwd(old_directory, sizeof(old_directory)) != NULL);
+
+	if(chdir(path) == -1)
+		return FAILURE;
+
+	if(have_old)
+		setenv("OLDPWD", old_directory, 1);
+
+	if(getcwd(new_directory, sizeof(new_directory)) != NULL)
+	{
+		setenv("PWD", new_directory, 1);
+		if(record_visits)
+			dirindex_add(new_directory);
+	}
+
+	return SUCCESS;
+
+} // End of 'change_to()'.
+
+
+
+/*======================================================================
+ * FUNCTION:	z_command()
+ * ARGUMENTS:	Command line parsed into strings for each argument.
+ * RETURNS:	Boolean true when user has called 'z'.
+ * 		Boolean false when user has not.
+ * DESCRIPTION: Function to change to highest scoring directory which
+ * 		matches every pattern given, ignoring case, when builtin
+ * 		command 'z' called.
+ * 		Only records in the shortest posting list of any trigram
+ * 		of the patterns are tested. If no pattern is three
+ * 		characters long, every record is tested.
+ * 		With no patterns, list highest scoring directories.
+ *====================================================================*/
+Boolean z_command(char** cmd_line)
+{
+	char *patterns[Z_MAX_PATTERNS + 1];
+	char path[DIRINDEX_MAX_PATH];
+	uint64_t offset, next, mask = 0;
+	uint64_t best[DIRINDEX_LIST_SIZE];
+	Dir_posting *rarest = NULL;
+	Dir_posting *posting;
+	uint32_t n;
+	size_t j;
+	double scores[DIRINDEX_LIST_SIZE];
+	double score;
+	Dir_record *record;
+	time_t now = time(NULL);
+	int wanted, found = 0;
+	int count, i;
+	char *p;
+
+	// If user has not called 'z':
+	if(strcmp(cmd_line[0],"z") != 0)
+		return FALSE;
+
+	// Lowercase patterns once, rather than paths on every search.
+	for(count = 0; count < Z_MAX_PATTERNS && cmd_line[count + 1] != NULL; count++)
+	{
+		if((patterns[count] = strdup(cmd_line[count + 1])) == NULL)
+			break;
+		for(p = patterns[count]; *p != '\0'; p++)
+			*p = tolower((unsigned char)*p);
+		mask |= dirindex_mask(patterns[count]);
+	}
+	patterns[count] = NULL;
+
+	// Only best match is needed when jumping, otherwise keep best few for listing.
+	wanted = (count > 0) ? 1 : DIRINDEX_LIST_SIZE;
+
+	pthread_mutex_lock(&index_lock);
+
+	if(dirindex_open() == FAILURE)
+	{
+		pthread_mutex_unlock(&index_lock);
+		fprintf(stderr, "z: Directory index not available.\n");
+		for(i = 0; i < count; i++) free(patterns[i]);
+		return TRUE;
+	}
+
+	// Exclusive lock, as tables may be updated from the file.
+	flock(index_fd, LOCK_EX);
+	dirindex_map(0);
+
+	if(count > 0 && dirindex_sync(TRUE) == SUCCESS)
+		for(i = 0; i < count; i++)
+			for(j = 0; patterns[i][j] != '\0' && patterns[i][j+1] != '\0' && patterns[i][j+2] != '\0'; j++)
+			{
+				posting = &postings[dirindex_trigram(&patterns[i][j])];
+				if(rarest == NULL || posting->count < rarest->count)
+					rarest = posting;
+			}
+
+	// Keep best scoring records in order, highest first.
+	for(n = 0, next = sizeof(Dir_header); (rarest != NULL) ? n < rarest->count : next < HEADER->used; n++)
+	{
+		offset = (rarest != NULL) ? rarest->offsets[n] : next;
+		record = RECORD(offset);
+		next = offset + record->size;
+
+		score = dirindex_score(record, now);
+
+		if(count > 0 && (score *= dirindex_match(record, patterns, mask)) == 0)
+			continue;
+
+		if(found == wanted && score <= scores[found - 1])
+			continue;
+
+		for(i = (found < wanted) ? found++ : found - 1; i > 0 && scores[i - 1] < score; i--)
+		{
+			scores[i] = scores[i - 1];
+			best[i] = best[i - 1];
+		}
+		scores[i] = score;
+		best[i] = offset;
+	}
+
+	if(count == 0)
+		for(i = 0; i < found; i++)
+			fprintf(BUILTIN_OUT, "%10.1f  %s\n", scores[i], RECORD(best[i])->text);
+	else if(found > 0)
+		snprintf(path, sizeof(path), "%s", RECORD(best[0])->text);
+
+	flock(index_fd, LOCK_UN);
+	pthread_mutex_unlock(&index_lock);
+
+	// Change directory once index is unlocked, as change_to() records the visit.
+	if(count > 0 && found == 0)
+		fprintf(stderr, "z: No directory matches.\n");
+	else if(count > 0 && change_to(path) == FAILURE)
+	{
+		fprintf(stderr, "z: %s: ", path);
+		perror(NULL);
+	}
+
+	for(i = 0; i < count; i++)
+		free(patterns[i]);
+
+	return TRUE;
+
+} // End of 'z_command()'.
+
+
+
+/*======================================================================
+ * FUNCTION:	pushd_command()
+ * ARGUMENTS:	Command line parsed into strings for each argument.
+ * RETURNS:	Boolean true when user has called 'pushd'.
+ * 		Boolean false when user has not.
+ * DESCRIPTION: Function to save current directory on directory stack
+ * 		and change to directory given, when builtin command
+ * 		'pushd' called. With no directory, swap current directory
+ * 		with the one on top of the stack.
+ *====================================================================*/
+Boolean pushd_command(char** cmd_line)
+{
+	char current[DIRINDEX_MAX_PATH];
+	char *target;
+	char *saved;
+
+	// If user has not called 'pushd':
+	if(strcmp(cmd_line[0],"pushd") != 0)
+		return FALSE;
+
+	if(getcwd(current, sizeof(current)) == NULL)
+	{
+		perror("pushd: getcwd()");
+		return TRUE;
+	}
+
+	if(cmd_line[1] == NULL && dir_stack_count == 0)
+	{
+		fprintf(stderr, "pushd: No other directory.\n");
+		return TRUE;
+	}
+
+	if(cmd_line[1] == NULL)
+		target = dir_stack[--dir_stack_count];
+	else if(dir_stack_count == DIRSTACK_SIZE)
+	{
+		fprintf(stderr, "pushd: Directory stack full.\n");
+		return TRUE;
+	}
+	else
+		target = cmd_line[1];
+
+	if((saved = strdup(current)) == NULL || change_to(target) == FAILURE)
+	{
+		fprintf(stderr, "pushd: %s: ", target);
+		perror(NULL);
+		free(saved);
+
+		// Put back directory taken from stack.
+		if(cmd_line[1] == NULL)
+			dir_stack_count++;
+		return TRUE;
+	}
+
+	if(cmd_line[1] == NULL)
+		free(target);
+
+	dir_stack[dir_stack_count++] = saved;
+	dirs_command((char *[]){"dirs", NULL});
+
+	return TRUE;
+
+} // End of 'pushd_command()'.
+
+
+
+/*======================================================================
+ * FUNCTION:	popd_command()
+ * ARGUMENTS:	Command line parsed into strings for each argument.
+ * RETURNS:	Boolean true when user has called 'popd'.
+ * 		Boolean false when user has not.
+ * DESCRIPTION: Function to change to directory on top of directory
+ * 		stack and remove it, when builtin command 'popd' called.
+ *====================================================================*/
+Boolean popd_command(char** cmd_line)
+{
+	char *target;
+
+	// If user has not called 'popd':
+	if(strcmp(cmd_line[0],"popd") != 0)
+		return FALSE;
+
+	if(dir_stack_count == 0)
+	{
+		fprintf(stderr, "popd: Directory stack empty.\n");
+		return TRUE;
+	}
+
+	target = dir_stack[dir_stack_count - 1];
+
+	if(change_to(target) == FAILURE)
+	{
+		fprintf(stderr, "popd: %s: ", target);
+		perror(NULL);
+	}
+
+	// Directory is removed from stack even if it no longer exists.
+	free(target);
+	dir_stack_count--;
+	dirs_command((char *[]){"dirs", NULL});
+
+	return TRUE;
+
+} // End of 'popd_command()'.
+
+
+
+/*======================================================================
+ * FUNCTION:	dirs_command()
+ * ARGUMENTS:	Command line parsed into strings for each argument.
+ * RETURNS:	Boolean true when user has called 'dirs'.
+ * 		Boolean false when user has not.
+ * DESCRIPTION: Function to print current directory followed by
+ * 		directory stack, top first, when builtin command 'dirs'
+ * 		called.
+ *====================================================================*/
+Boolean dirs_command(char** cmd_line)
+{
+	char current[DIRINDEX_MAX_PATH];
+	int i;
+
+	// If user has not called 'dirs':
+	if(strcmp(cmd_line[0],"dirs") != 0)
+		return FALSE;
+
+	fprintf(BUILTIN_OUT, "%s", getcwd(current, sizeof(current)) != NULL ? current : "?");
+	for(i = dir_stack_count - 1; i >= 0; i--)
+		fprintf(BUILTIN_OUT, " %s", dir_stack[i]);
+	fprintf(BUILTIN_OUT, "\n");
+
+	return TRUE;
+
+} // End of 'dirs_command()'.
@@ -20,9 +20,17 @@
 				> shell_prompt()
 				> redirect_stdout_to_files()
 				> help()
+				> find_builtin()
+				> is_builtin()
+				> changes_shell_state()
+				> run_builtin()
 				> change_directory()
+				> add_token()
 				> parse_cmd()
 				> execute_command()
+				> traced_fork()
+				> child_exec()
+				> catch_parent_signals()
 				
 	Author:      	Cian O'Mahoney
 	Student Number:	19351611
@@ -48,7 +56,11 @@ Systems header files
 #include <errno.h>	// For perror(), errno
 #include <fcntl.h>	// For dup(), dup2(), open()
 #include <signal.h>	// For SIGINT, SIGQUIT
-#include <sys/wait.h>	// For wait()
+#include <sys/wait.h>	// For waitpid()
+
+
+
+volatile sig_atomic_t interrupt_count = 0;	// Interrupts received after fork().
 
 
 
@@ -63,6 +75,8 @@ Systems header files
  *====================================================================*/
 void sig_handler(int signo)
 {
+	TRACE(TRACE_SIGNAL, PHASE_INSTANT, signo);
+
 	// If interrupt signal recieved:
 	if(signo == SIGINT)
 	{
@@ -91,8 +105,11 @@ void sig_handler(int signo)
  *====================================================================*/
 void parent_sig_handler(int signo)
 {
+	TRACE(TRACE_SIGNAL, PHASE_INSTANT, signo);
+
 	if(signo == SIGINT)
 	{
+		interrupt_count++;
 		printf("\n");
 		fflush(stdout);
 	}
@@ -284,6 +301,7 @@ Operation redirect_stdout_to_file(char* filename, int* file_des, int* save_out)
  * 		Boolean false when user has not.
  * DESCRIPTION: Function to change working directory of shell when 
  * 		user calls builtin command 'cd'.
+ * 		Path '-' changes back to previous directory.
  *====================================================================*/
 Boolean change_directory(char** cmd_line)
 {
@@ -301,10 +319,22 @@ Boolean change_directory(char** cmd_line)
 				return TRUE;
 			}
 
+		// If user specifies path '-':
+		// Change to previous directory given by environment variable 'OLDPWD'.
+		if(strcmp(cmd_line[1],"-") == 0)
+		{
+			if((cmd_line[1] = getenv("OLDPWD")) == NULL)
+			{
+				fprintf(stderr,"cd: No previous directory.\n");
+				return TRUE;
+			}
+			fprintf(BUILTIN_OUT, "%s\n", cmd_line[1]);
+		}
+
 		// Change directory to path supplied as second
-		// argument in command line.
+		// argument in command line, recording it for builtin command 'z'.
 		// If unable to change to path given, print error.
-		if(chdir(cmd_line[1]) == -1)
+		if(change_to(cmd_line[1]) == FAILURE)
 		{
 			fprintf(stderr, "cd: %s: ", cmd_line[1]);
 			perror(NULL);
@@ -339,53 +369,130 @@ Boolean help(char** cmd_line)
 		// Print general help message.
 		if(second_arg == NULL)
 		{
-			printf("\nHELP INFORMATION:\n\n");
-			printf("GENERAL USAGE:\tcommand [option(s)]... [filename(s)]\n");
-			printf("For more information regarding user commands try 'man'.\n");
-			printf("For more information regarding builtin commands try 'help [builtin command]'\n\n");
+			fprintf(BUILTIN_OUT, "\nHELP INFORMATION:\n\n");
+			fprintf(BUILTIN_OUT, "GENERAL USAGE:\tcommand [option(s)]... [filename(s)]\n");
+			fprintf(BUILTIN_OUT, "For more information regarding user commands try 'man'.\n");
+			fprintf(BUILTIN_OUT, "Commands may be joined with '|'. Builtin commands in a pipeline run on a thread.\n");
+			fprintf(BUILTIN_OUT, "For more information regarding builtin commands try 'help [builtin command]'\n\n");
 		}
 		// If 'cd' argument supplied with help:
 		// Print help message for builtin command 'cd'.
 		else if(strcmp(second_arg,"cd") == 0)	
 		{
-			printf("\nCD:\t\tBUILTIN COMMAND\n\n");
-			printf("NAME:\t\tcd\n");
-			printf("DESCRIPTION:\tChange working directory.\n");
-			printf("USAGE:\t\tcd [path]\n\n");
+			fprintf(BUILTIN_OUT, "\nCD:\t\tBUILTIN COMMAND\n\n");
+			fprintf(BUILTIN_OUT, "NAME:\t\tcd\n");
+			fprintf(BUILTIN_OUT, "DESCRIPTION:\tChange working directory.\n");
+			fprintf(BUILTIN_OUT, "USAGE:\t\tcd [path | -]\n\n");
 		}
 		// If 'help' argument supplied with help:
 		// Print help message for built in command 'help'.
 		else if(strcmp(second_arg,"help") == 0)
 		{
-			printf("\nHELP:\t\tBUILTIN COMMAND\n\n");
-			printf("NAME:\t\thelp\n");
-			printf("DESCRIPTION:\tDispay information about builtin commands.\n");
-			printf("USAGE:\t\thelp [builtin command]\n\n");
+			fprintf(BUILTIN_OUT, "\nHELP:\t\tBUILTIN COMMAND\n\n");
+			fprintf(BUILTIN_OUT, "NAME:\t\thelp\n");
+			fprintf(BUILTIN_OUT, "DESCRIPTION:\tDispay information about builtin commands.\n");
+			fprintf(BUILTIN_OUT, "USAGE:\t\thelp [builtin command]\n\n");
+		}
+		// If 'trace' argument supplied with help:
+		// Print help message for built in command 'trace'.
+		else if(strcmp(second_arg,"trace") == 0)
+		{
+			fprintf(BUILTIN_OUT, "\nTRACE:\t\tBUILTIN COMMAND\n\n");
+			fprintf(BUILTIN_OUT, "NAME:\t\ttrace\n");
+			fprintf(BUILTIN_OUT, "DESCRIPTION:\tRecord shell events (read, parse, fork, exec, exit, signal).\n");
+			fprintf(BUILTIN_OUT, "\t\t'dump' prints events as Chrome trace JSON, viewable in Perfetto.\n");
+			fprintf(BUILTIN_OUT, "USAGE:\t\ttrace [on | off | clear | dump]\n\n");
+		}
+		// If 'batch' argument supplied with help:
+		// Print help message for built in command 'batch'.
+		else if(strcmp(second_arg,"batch") == 0)
+		{
+			fprintf(BUILTIN_OUT, "\nBATCH:\t\tBUILTIN COMMAND\n\n");
+			fprintf(BUILTIN_OUT, "NAME:\t\tbatch\n");
+			fprintf(BUILTIN_OUT, "DESCRIPTION:\tRun command with as many items as ARG_MAX allows per process.\n");
+			fprintf(BUILTIN_OUT, "\t\tItems are read from stdin, one per line, unless '-g' given.\n");
+			fprintf(BUILTIN_OUT, "\t\t'-P' sets how many batches may run at once.\n");
+			fprintf(BUILTIN_OUT, "USAGE:\t\tbatch [-P jobs] [-g pattern]... command [argument(s)]\n\n");
+		}
+		// If 'jobtop' argument supplied with help:
+		// Print help message for built in command 'jobtop'.
+		else if(strcmp(second_arg,"jobtop") == 0)
+		{
+			fprintf(BUILTIN_OUT, "\nJOBTOP:\t\tBUILTIN COMMAND\n\n");
+			fprintf(BUILTIN_OUT, "NAME:\t\tjobtop\n");
+			fprintf(BUILTIN_OUT, "DESCRIPTION:\tRun command, showing CPU%%, memory and I/O of its process tree.\n");
+			fprintf(BUILTIN_OUT, "\t\tA line is printed to stderr every interval, 1000 msec by default.\n");
+			fprintf(BUILTIN_OUT, "USAGE:\t\tjobtop [-d msec] command [argument(s)]\n\n");
+		}
+		// If 'shellprof' argument supplied with help:
+		// Print help message for built in command 'shellprof'.
+		else if(strcmp(second_arg,"shellprof") == 0)
+		{
+			fprintf(BUILTIN_OUT, "\nSHELLPROF:\tBUILTIN COMMAND\n\n");
+			fprintf(BUILTIN_OUT, "NAME:\t\tshellprof\n");
+			fprintf(BUILTIN_OUT, "DESCRIPTION:\tShow histograms of time the shell spends in each phase:\n");
+			fprintf(BUILTIN_OUT, "\t\tprompt, read, parse, redirect, dispatch and fork.\n");
+			fprintf(BUILTIN_OUT, "USAGE:\t\tshellprof [phase | reset]\n\n");
+		}
+		// If 'cat', 'cp' or 'tee' argument supplied with help:
+		// Print help message for built in file copying commands.
+		else if(strcmp(second_arg,"cat") == 0 || strcmp(second_arg,"cp") == 0 || strcmp(second_arg,"tee") == 0)
+		{
+			fprintf(BUILTIN_OUT, "\nCAT, CP, TEE:\tBUILTIN COMMANDS\n\n");
+			fprintf(BUILTIN_OUT, "NAME:\t\tcat, cp, tee\n");
+			fprintf(BUILTIN_OUT, "DESCRIPTION:\tCopy data without starting a new process.\n");
+			fprintf(BUILTIN_OUT, "\t\tData is moved inside the kernel where possible.\n");
+			fprintf(BUILTIN_OUT, "USAGE:\t\tcat [file(s)]\n");
+			fprintf(BUILTIN_OUT, "\t\tcp source(s)... destination\n");
+			fprintf(BUILTIN_OUT, "\t\ttee [-a] [file(s)]\n\n");
+		}
+		// If 'z' argument supplied with help:
+		// Print help message for built in command 'z'.
+		else if(strcmp(second_arg,"z") == 0)
+		{
+			fprintf(BUILTIN_OUT, "\nZ:\t\tBUILTIN COMMAND\n\n");
+			fprintf(BUILTIN_OUT, "NAME:\t\tz\n");
+			fprintf(BUILTIN_OUT, "DESCRIPTION:\tChange to most frequently and recently used directory\n");
+			fprintf(BUILTIN_OUT, "\t\tmatching every pattern in order, ignoring case. Directories whose\n");
+			fprintf(BUILTIN_OUT, "\t\tfinal component matches last pattern are preferred.\n");
+			fprintf(BUILTIN_OUT, "\t\tWith no pattern, list best directories.\n");
+			fprintf(BUILTIN_OUT, "USAGE:\t\tz [pattern(s)]\n\n");
+		}
+		// If 'pushd', 'popd' or 'dirs' argument supplied with help:
+		// Print help message for built in directory stack commands.
+		else if(strcmp(second_arg,"pushd") == 0 || strcmp(second_arg,"popd") == 0 || strcmp(second_arg,"dirs") == 0)
+		{
+			fprintf(BUILTIN_OUT, "\nPUSHD, POPD, DIRS:\tBUILTIN COMMANDS\n\n");
+			fprintf(BUILTIN_OUT, "NAME:\t\tpushd, popd, dirs\n");
+			fprintf(BUILTIN_OUT, "DESCRIPTION:\tSave directory on stack and change to path, or swap with top.\n");
+			fprintf(BUILTIN_OUT, "\t\tChange to directory on top of stack and remove it.\n");
+			fprintf(BUILTIN_OUT, "\t\tPrint directory stack.\n");
+			fprintf(BUILTIN_OUT, "USAGE:\t\tpushd [path]\n\t\tpopd\n\t\tdirs\n\n");
 		}
 		// If 'logout' argument supplied with help:
 		// Print help message for built in command 'logout'.
 		else if(strcmp(second_arg,"logout") == 0)
 		{
-			printf("\nLOGOUT:\t\tBUILTIN COMMAND\n\n");
-			printf("NAME:\t\tlogout\n");
-			printf("DESCRIPTION:\tLog out from current user session.\n");
-			printf("USAGE:\t\tlogout\n\n");
+			fprintf(BUILTIN_OUT, "\nLOGOUT:\t\tBUILTIN COMMAND\n\n");
+			fprintf(BUILTIN_OUT, "NAME:\t\tlogout\n");
+			fprintf(BUILTIN_OUT, "DESCRIPTION:\tLog out from current user session.\n");
+			fprintf(BUILTIN_OUT, "USAGE:\t\tlogout\n\n");
 		}
 		// If 'exit' argument supplied with help:
 		// Print help message for built in command 'exit'.
 		else if(strcmp(second_arg,"exit") == 0)
 		{
-			printf("\nEXIT:\t\tBUILTIN COMMAND\n\n");
-			printf("NAME:\t\texit\n");
-			printf("DESCRIPTION:\tExit shell.\n");
-			printf("USAGE:\t\texit\n\n");
+			fprintf(BUILTIN_OUT, "\nEXIT:\t\tBUILTIN COMMAND\n\n");
+			fprintf(BUILTIN_OUT, "NAME:\t\texit\n");
+			fprintf(BUILTIN_OUT, "DESCRIPTION:\tExit shell.\n");
+			fprintf(BUILTIN_OUT, "USAGE:\t\texit\n\n");
 		}
 		// If argument supplied with help command, but argument does not match any command with information stored:
 		// Offer alternative sources for information.
 		else
 		{
-			printf("help: no help topics match '%s'.",second_arg);
-		      	printf(" Try 'help help' or 'man -k %s' or 'info %s'.\n",second_arg,second_arg);
+			fprintf(BUILTIN_OUT, "help: no help topics match '%s'.",second_arg);
+		      	fprintf(BUILTIN_OUT, " Try 'help help' or 'man -k %s' or 'info %s'.\n",second_arg,second_arg);
 		}
 
 		return TRUE;
@@ -394,6 +501,143 @@ Boolean help(char** cmd_line)
 
 
 
+/*======================================================================
+ Builtin commands run by run_builtin()
+======================================================================*/
+typedef struct
+{
+	const char *name;		// Name typed by user.
+	Boolean (*handler)(char **);	// Function which runs command.
+} Builtin;
+
+static const Builtin builtins[] = {
+	{"help", help}, {"cd", change_directory}, {"trace", trace_command},
+	{"batch", batch_command}, {"jobtop", jobtop_command}, {"shellprof", shellprof_command},
+	{"cat", cat_command}, {"cp", cp_command}, {"tee", tee_command},
+	{"z", z_command}, {"pushd", pushd_command}, {"popd", popd_command},
+	{"dirs", dirs_command}, {NULL, NULL}};
+
+
+
+/*======================================================================
+ * FUNCTION:	find_builtin()
+ * ARGUMENTS:	Name of command.
+ * RETURNS:	Pointer to builtin, or NULL when command is not builtin.
+ * DESCRIPTION: Function to look up builtin command by name.
+ *====================================================================*/
+static const Builtin *find_builtin(char* name)
+{
+	int i;
+
+	for(i = 0; builtins[i].name != NULL; i++)
+		if(strcmp(name, builtins[i].name) == 0)
+			return &builtins[i];
+
+	return NULL;
+
+} // End of 'find_builtin()'.
+
+
+
+/*======================================================================
+ * FUNCTION:	is_builtin()
+ * ARGUMENTS:	Name of command.
+ * RETURNS:	Boolean true when command is a builtin command
+ * 		handled by run_builtin(), Boolean false when not.
+ * DESCRIPTION: Function to check if a command is builtin, without
+ * 		running it.
+ *====================================================================*/
+Boolean is_builtin(char* name)
+{
+	return find_builtin(name) != NULL;
+
+} // End of 'is_builtin()'.
+
+
+
+/*======================================================================
+ * FUNCTION:	changes_shell_state()
+ * ARGUMENTS:	Name of command.
+ * RETURNS:	Boolean true when command is a builtin which changes
+ * 		working directory or environment of the shell,
+ * 		Boolean false when not.
+ * DESCRIPTION: Function to check if a builtin must not run on a
+ * 		pipeline thread, as setenv() would race with other
+ * 		stages reading the environment.
+ *====================================================================*/
+Boolean changes_shell_state(char* name)
+{
+	static const char *builtins[] = {"cd", "z", "pushd", "popd", NULL};
+	int i;
+
+	for(i = 0; builtins[i] != NULL; i++)
+		if(strcmp(name, builtins[i]) == 0)
+			return TRUE;
+
+	return FALSE;
+
+} // End of 'changes_shell_state()'.
+
+
+
+/*======================================================================
+ * FUNCTION:	run_builtin()
+ * ARGUMENTS:	Command line parsed into strings for each argument.
+ * RETURNS:	Boolean true when a builtin command was run.
+ * 		Boolean false when command is not builtin.
+ * DESCRIPTION: Function to look up builtin command and run it.
+ * 		Builtins 'logout' and 'exit' are handled by main().
+ * 		Only time taken to look up command is recorded as the
+ * 		dispatch phase, not time taken by command itself.
+ *====================================================================*/
+Boolean run_builtin(char** cmd_line)
+{
+	unsigned long long prof_start;
+	const Builtin *builtin;
+
+	PROF_BEGIN(prof_start, dispatch);
+	builtin = find_builtin(cmd_line[0]);
+	PROF_END(prof_start, PROF_DISPATCH, dispatch);
+
+	if(builtin == NULL)
+		return FALSE;
+
+	return builtin->handler(cmd_line);
+
+} // End of 'run_builtin()'.
+
+
+
+/*======================================================================
+ * FUNCTION:	add_token()
+ * ARGUMENTS:	token_holder: Pointer to array of tokens to add to.
+ * 		count:	      Pointer to number of tokens in array.
+ * 		token:	      Token to add.
+ * RETURNS:	Nothing.
+ * DESCRIPTION: Function to append a token to array built by parse_cmd(),
+ * 		growing array so there is always room for a final NULL.
+ *====================================================================*/
+static void add_token(char*** token_holder, int* count, char* token)
+{
+	char** grown;
+
+	(*token_holder)[*count] = token;
+	(*count)++;
+
+	// Allocate memory for any further tokens extracted from unparsed string.
+	if((grown = (char **)realloc(*token_holder, (*count + 1) * sizeof(char*))) == NULL)
+	{
+		fprintf(stderr, "parse_cmd(): realloc: Failed to reallocate memory.\n");
+		free(*token_holder);
+		exit(EXIT_FAILURE);
+	}
+
+	*token_holder = grown;
+
+} // End of 'add_token()'.
+
+
+
 /*======================================================================
  * FUNCTION:	parse_cmd()
  * ARGUMENTS:	Pointer to unparsed command line.
@@ -408,6 +652,7 @@ Operation parse_cmd(char* unparsed, char*** parsed)
 	int count = 0;			// To count number of tokens extracted from unparsed string.
 	char* token = NULL;		// To temporarily hold token extracted from unparsed string.
 	char** token_holder = NULL;	// Array to temporarily hold tokens parsed from command line string.
+	char* pipe_symbol = NULL;	// Position of pipe symbol within token, if any.
 	
 	// Allocate memory for first token in token_holder.
 	if((token_holder = (char **)malloc(sizeof(char*))) == NULL)
@@ -422,18 +667,20 @@ Operation parse_cmd(char* unparsed, char*** parsed)
 	// Extract any remaining tokens from unparsed string.
 	while(token != NULL)
 	{	
-		// Put tokens into token_holder.
-		token_holder[count] = token;
-		count++;
-		
-		// Allocate memory for any further tokens extracted from unparsed string.
-		if((token_holder = (char **)realloc(token_holder, (count + 1) * sizeof(char*))) == NULL)
+		// A pipe symbol is a token of its own, even without spaces around it.
+		while((pipe_symbol = strchr(token, PIPE_SYMBOL[0])) != NULL)
 		{
-			fprintf(stderr, "parse_cmd(): realloc: Failed to reallocate memory.\n");
-			free(token_holder);
-			exit(EXIT_FAILURE);
+			*pipe_symbol = '\0';
+			if(token[0] != '\0')
+				add_token(&token_holder, &count, token);
+			add_token(&token_holder, &count, PIPE_SYMBOL);
+			token = pipe_symbol + 1;
 		}
 
+		// Put tokens into token_holder.
+		if(token[0] != '\0')
+			add_token(&token_holder, &count, token);
+
 		// Extract another token from unparsed string, deliminated by a space character.
 		token = strtok(NULL, " ");
 	}
@@ -471,7 +718,7 @@ Operation execute_command(char** command)
 	int child_status;	// To hold child process exit status.
 
 	// Fork process:
-	child_pid = fork();
+	child_pid = traced_fork();
 
 	// If fork() failed, return with failure:
 	if(child_pid == -1)
@@ -484,6 +731,7 @@ Operation execute_command(char** command)
 	if(child_pid == 0)
 	{
 		// Replace process with that specified in command line:
+		TRACE(TRACE_EXEC, PHASE_INSTANT, 0);
 		execvp(command[0], command);
 
 		// If unable to execute program called:
@@ -505,8 +753,9 @@ Operation execute_command(char** command)
 		
 		if(debug) fprintf(stdout ,"Parent waiting.\n");
 
-		// Wait for child process to finish:
-		wait(&child_status);
+		// Wait for child process to finish, not for an orphan adopted by 'jobtop':
+		waitpid(child_pid, &child_status, 0);
+		TRACE(TRACE_EXIT, PHASE_INSTANT, child_status);
 	}
 		
 	if(debug) fprintf(stdout, "Parent exiting.\n");
@@ -514,3 +763,83 @@ Operation execute_command(char** command)
 	return SUCCESS;
 
 } // End of 'execute_command()'.
+
+
+
+/*======================================================================
+ * FUNCTION:	traced_fork()
+ * ARGUMENTS:	None.
+ * RETURNS:	Process identifier of child in parent, 0 in child,
+ * 		or -1 if fork() failed.
+ * DESCRIPTION: Function to fork a child process, recording the
+ * 		fork for 'trace' and its duration for 'shellprof'.
+ * 		Only the parent records the end of the fork.
+ *====================================================================*/
+pid_t traced_fork(void)
+{
+	unsigned long long prof_start;
+	pid_t child_pid;
+
+	TRACE(TRACE_FORK, PHASE_BEGIN, 0);
+	PROF_BEGIN(prof_start, fork);
+	child_pid = fork();
+
+	if(child_pid != 0)
+	{
+		PROF_END(prof_start, PROF_FORK, fork);
+		TRACE(TRACE_FORK, PHASE_END, child_pid);
+	}
+
+	return child_pid;
+
+} // End of 'traced_fork()'.
+
+
+
+/*======================================================================
+ * FUNCTION:	child_exec()
+ * ARGUMENTS:	Command line parsed into strings for each argument.
+ * RETURNS:	Does not return.
+ * DESCRIPTION: Function to replace a child forked by a builtin or
+ * 		pipeline with command, or exit if command is not found.
+ * 		Another thread of the shell may have held a stdio lock
+ * 		when child was forked, so error is written with write().
+ *====================================================================*/
+void child_exec(char** command)
+{
+	char message[MAX_BUFFER];
+	size_t length = strlen(command[0]);
+	const char *suffix = ": command not found.\n";
+
+	TRACE(TRACE_EXEC, PHASE_INSTANT, 0);
+	execvp(command[0], command);
+
+	if(length > sizeof(message) - strlen(suffix) - 1)
+		length = sizeof(message) - strlen(suffix) - 1;
+	memcpy(message, command[0], length);
+	memcpy(message + length, suffix, strlen(suffix));
+
+	// Nothing more can be done if error cannot be written.
+	if(write(STDERR_FD, message, length + strlen(suffix)) == -1)
+		_exit(EXIT_FAILURE);
+	_exit(EXIT_FAILURE);
+
+} // End of 'child_exec()'.
+
+
+
+/*======================================================================
+ * FUNCTION:	catch_parent_signals()
+ * ARGUMENTS:	Name of caller, for error message.
+ * RETURNS:	Nothing.
+ * DESCRIPTION: Function to handle interrupt signal with
+ * 		parent_sig_handler() while a builtin or pipeline waits
+ * 		for its children, as execute_command() does, so an
+ * 		interrupt stops the children but not the shell.
+ *====================================================================*/
+void catch_parent_signals(const char* caller)
+{
+	if(signal(SIGINT, parent_sig_handler) == SIG_ERR)
+		fprintf(stderr, "%s: signal(): An error occurred while setting a signal handler.\n", caller);
+
+} // End of 'catch_parent_signals()'.
@@ -27,6 +27,12 @@
 #ifndef HEADER_H_INCLUDED
 #define HEADER_H_INCLUDED
 
+#include <stdio.h>		// For FILE
+#include <signal.h>		// For sig_atomic_t
+#include <sys/types.h>		// For pid_t
+
+#include "sdt.h"			// For DTRACE_PROBE()
+
 
 
 /*======================================================================
@@ -45,10 +51,64 @@
 
 #define STDOUT_FD 1		// Standard output file descriptor.
 
+#define STDERR_FD 2		// Standard error file descriptor.
+
 #define WIDTH 80		// Width of decorative printing.
 
 #define PROMPT_CHARACTER '#'	// Special character to print in prompt.
 
+#define TRACE_BUFFER_SIZE 8192	// Number of records held by trace ring buffer.
+				// Must be a power of two.
+
+#define BATCH_HEADROOM 2048	// Bytes of ARG_MAX left unused by 'batch'.
+
+#define BATCH_MIN_ARG_SPACE 4096 // Smallest argument space 'batch' will assume.
+
+#define STDIN_FD 0		// Standard input file descriptor.
+
+#define PIPE_SYMBOL "|"		// Token separating stages of a pipeline.
+
+#define JOBTOP_INITIAL_PROCESSES 256 // Processes 'jobtop' first allocates room for.
+				// Each holds three open files.
+
+#define JOBTOP_INTERVAL_MS 1000	// Default 'jobtop' sampling interval.
+
+#define JOBTOP_POLL_MS 20	// How often 'jobtop' checks if job has exited.
+
+#define JOBTOP_READ_SIZE 1024	// Buffer for reading a single /proc file.
+
+#define PROF_BUCKETS 40		// Power of two nanosecond buckets per phase.
+
+#define PROF_BAR_WIDTH 40	// Width of longest 'shellprof' histogram bar.
+
+#define COPY_BUFFER_SIZE (1 << 20) // Buffer used when kernel cannot copy directly.
+
+#define COPY_CHUNK_SIZE (1 << 30) // Most bytes asked of kernel in a single copy.
+
+#define TEE_MAX_FILES 32	// Most files 'tee' writes to at once.
+
+#define DIRSTACK_SIZE 64	// Most directories 'pushd' can save.
+
+#define DIRINDEX_MAGIC 0x5a444953 // Identifies directory index file.
+
+#define DIRINDEX_TABLE_SIZE 1024 // Initial slots in directory path hash table.
+
+#define DIRINDEX_TRIGRAM_BITS 14 // Directory trigram posting lists, as power of two.
+
+#define DIRINDEX_INITIAL_SIZE (1 << 20) // Initial size of directory index file.
+
+#define DIRINDEX_MAX_PATH 4096	// Longest path recorded in directory index.
+
+#define DIRINDEX_MAX_RANK 1000000.0 // Total rank at which directory index is aged.
+
+#define DIRINDEX_AGE_FACTOR 0.99 // Rank kept by each directory when index is aged.
+
+#define DIRINDEX_LIST_SIZE 10	// Directories listed by 'z' with no pattern.
+
+#define DIRINDEX_BASE_WEIGHT 4	// Score weight when final component matches.
+
+#define Z_MAX_PATTERNS 16	// Most patterns 'z' matches at once.
+
 
 /*======================================================================
  TYPE DEFINITIONS
@@ -57,12 +117,55 @@
 typedef enum{FAILURE, SUCCESS} Operation;
 typedef enum{P_FAILURE, P_SUCCESS} Print;
 typedef enum{FALSE, TRUE} Boolean;
+typedef enum{TRACE_READ, TRACE_PARSE, TRACE_FORK, TRACE_EXEC,
+	     TRACE_EXIT, TRACE_SIGNAL} Event;
+typedef enum{PHASE_BEGIN = 'B', PHASE_END = 'E', PHASE_INSTANT = 'i'} Phase;
+typedef enum{PROF_PROMPT, PROF_READ, PROF_PARSE, PROF_REDIRECT,
+	     PROF_DISPATCH, PROF_FORK, PROF_PHASES} Prof_phase;
 
 
 /*======================================================================
  MACRO DEFINITIONS
 ======================================================================*/
 
+// Record trace event if tracing is enabled.
+// When tracing is disabled this costs a single branch.
+#define TRACE(event, phase, arg) \
+	do { if(__builtin_expect(trace_enabled, 0)) trace_record(event, phase, arg); } while(0)
+
+// Streams used by builtin commands.
+// Builtins running as pipeline stages on a thread read and write their
+// own pipe, all others use the shell's stdin and stdout.
+#define BUILTIN_IN  (builtin_in  != NULL ? builtin_in  : stdin)
+#define BUILTIN_OUT (builtin_out != NULL ? builtin_out : stdout)
+
+// Static probe point, named 'name' under provider 'assign2_19351611'.
+#define SHELL_PROBE(name) DTRACE_PROBE(assign2_19351611, name)
+#define SHELL_PROBE1(name, arg) DTRACE_PROBE1(assign2_19351611, name, arg)
+
+// Time a phase of the shell for builtin command 'shellprof'.
+// Probes 'name__start' and 'name__done' fire at either end, the latter
+// with the phase duration in nanoseconds.
+#define PROF_BEGIN(start, name) \
+	do { SHELL_PROBE(name##__start); (start) = prof_clock(); } while(0)
+#define PROF_END(start, phase, name) \
+	do { unsigned long long prof_ns = prof_clock() - (start); \
+	     prof_record(phase, prof_ns); SHELL_PROBE1(name##__done, prof_ns); } while(0)
+
+
+/*======================================================================
+ GLOBAL VARIABLES
+======================================================================*/
+
+extern volatile int trace_enabled;
+
+extern volatile sig_atomic_t interrupt_count;
+
+extern Boolean record_visits;
+
+extern __thread FILE *builtin_in;
+extern __thread FILE *builtin_out;
+
 
 /*======================================================================
  FUNCTION PROTOTYPES
@@ -78,8 +181,39 @@ Print decorative_line(char);
 Operation redirect_stdout_to_file(char*,int*,int*);
 Operation parse_cmd(char*, char***);
 Operation execute_command(char**);
+pid_t traced_fork(void);
+void child_exec(char **);
+void catch_parent_signals(const char *);
 
 Boolean change_directory(char **);
 Boolean help(char **);
+Boolean is_builtin(char *);
+Boolean changes_shell_state(char *);
+Boolean run_builtin(char **);
+
+void trace_init(void);
+void trace_record(Event, Phase, long);
+Boolean trace_command(char **);
+
+Boolean batch_command(char **);
+
+Boolean pipeline(char **);
+void builtin_child_fds(void);
+
+Boolean jobtop_command(char **);
+
+unsigned long long prof_clock(void);
+void prof_record(Prof_phase, unsigned long long);
+Boolean shellprof_command(char **);
+
+Boolean cat_command(char **);
+Boolean cp_command(char **);
+Boolean tee_command(char **);
+
+Operation change_to(char *);
+Boolean z_command(char **);
+Boolean pushd_command(char **);
+Boolean popd_command(char **);
+Boolean dirs_command(char **);
 
 #endif
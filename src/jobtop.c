@@ -0,0 +1,858 @@
+/*======================================================================
+
+	University College Dublin
+	COMP20200 - UNIX Programming
+
+	Assignment 2: 	Implement a simple shell
+
+	Project:	assign2_19351611
+	File Name:   	jobtop.c
+	Description: 	Simple UNIX shell program.
+			Reads line from stdin and executes command.
+			This file contains the builtin command 'jobtop',
+			which runs a command and, while waiting for it,
+			samples /proc for every process of the job to
+			show its CPU, memory and I/O use.
+			Shell becomes a child subreaper while a job runs, so
+			orphans of the job are adopted by the shell and its
+			processes can be found by following children from
+			the command, without reading every process on the
+			system.
+
+			These include:
+				> jobtop_file()
+				> jobtop_compare()
+				> jobtop_find()
+				> jobtop_add()
+				> jobtop_stat()
+				> jobtop_child()
+				> jobtop_children()
+				> jobtop_walk()
+				> jobtop_scan()
+				> jobtop_read()
+				> jobtop_sample()
+				> jobtop_foreground()
+				> jobtop_subreaper()
+				> jobtop_command()
+
+	Author:      	Cian O'Mahoney
+	Student Number:	19351611
+	Email:		cian.omahoney@ucdconnect.ie
+	Date:        	15/2/2021
+	Version:     	1.0
+
+======================================================================*/
+
+
+
+/*======================================================================
+Systems header files
+======================================================================*/
+#include <config.h>
+#include "header.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>	// For strcmp(), strrchr(), strtok_r()
+#include <unistd.h>	// For read(), close(), fork(), setpgid(), tcsetpgrp()
+#include <fcntl.h>	// For openat(), faccessat()
+#include <dirent.h>	// For opendir(), fdopendir(), readdir(), dirfd()
+#include <ctype.h>	// For isdigit()
+#include <signal.h>	// For signal(), kill(), SIGINT
+#include <time.h>	// For clock_gettime(), nanosleep()
+#include <pthread.h>	// For pthread_mutex_lock()
+#include <sys/wait.h>	// For waitpid()
+#include <sys/prctl.h>	// For prctl(), PR_SET_CHILD_SUBREAPER
+
+
+
+static pthread_mutex_t subreaper_lock = PTHREAD_MUTEX_INITIALIZER;
+static int subreaper_jobs = 0;		// Jobs needing shell to be a subreaper.
+static Boolean subreaper_set = FALSE;	// Shell was made a subreaper.
+
+
+
+/*======================================================================
+ State of a single sampled process
+======================================================================*/
+typedef struct
+{
+	pid_t pid;			// Process identifier.
+	pid_t ppid;			// Parent process identifier.
+	pid_t pgid;			// Process group identifier.
+	unsigned long long start;	// Start time, to detect reuse of pid.
+	unsigned long long cpu;		// User plus system clock ticks.
+	unsigned long long rss;		// Resident pages.
+	unsigned long long read;	// Bytes read.
+	unsigned long long written;	// Bytes written.
+	int threads;			// Threads, each of which may have children.
+	unsigned long long read_delta;	// Bytes read since previous sample.
+	unsigned long long written_delta;// Bytes written since previous sample.
+	Boolean member;			// Process belongs to job.
+} Process;
+
+typedef struct
+{
+	Process *processes;		// Sorted by pid once filled.
+	int count;			// Processes in list.
+	int capacity;			// Processes allocated.
+} Process_list;
+
+typedef struct
+{
+	DIR *proc;			// Open /proc, reused by every sample.
+	Process_list scan;		// Processes found by latest sample.
+	Process_list members;		// Processes of job in latest sample.
+	Process_list next;		// Processes of job being sampled.
+	pid_t root;			// Command started by jobtop.
+	pid_t pgid;			// Process group of command started.
+	Boolean full_scan;		// Children may not be followed, so read every process.
+	Boolean alone;			// Shell has no other children but those left by earlier jobs.
+	unsigned long long start;	// Start time of command.
+	int count;			// Processes in latest sample.
+	int peak_count;			// Most processes seen at once.
+	unsigned long long peak_rss;	// Most resident pages seen at once.
+	unsigned long long first_rss;	// Resident pages in first sample.
+	unsigned long long rss;		// Total resident pages in latest sample.
+	unsigned long long cpu;		// Ticks used since previous sample.
+	unsigned long long read;	// Bytes read since previous sample.
+	unsigned long long written;	// Bytes written since previous sample.
+	Boolean sampled;		// At least one sample taken.
+} Job;
+
+
+
+/*======================================================================
+ * FUNCTION:	jobtop_file()
+ * ARGUMENTS:	job:	Job being sampled.
+ * 		pid:	Process to read file of.
+ * 		name:	Name of file in /proc/<pid>.
+ * 		buffer:	Buffer of JOBTOP_READ_SIZE bytes to read into.
+ * RETURNS:	Length read, or -1 if process has gone.
+ * DESCRIPTION: Function to read a file of a process into buffer as a
+ * 		string. File is opened relative to the /proc directory
+ * 		held open by job and closed again, so only one descriptor
+ * 		is used however many processes a job has.
+ *====================================================================*/
+static ssize_t jobtop_file(Job *job, pid_t pid, const char *name, char *buffer)
+{
+	char path[MAX_BUFFER];
+	ssize_t length = 0;
+	ssize_t bytes;
+	int fd;
+
+	snprintf(path, sizeof(path), "%d/%s", (int)pid, name);
+	if((fd = openat(dirfd(job->proc), path, O_RDONLY | O_CLOEXEC)) == -1)
+		return -1;
+
+	while(length < JOBTOP_READ_SIZE - 1 &&
+			(bytes = read(fd, buffer + length, JOBTOP_READ_SIZE - 1 - length)) > 0)
+		length += bytes;
+
+	close(fd);
+	buffer[length] = '\0';
+
+	return length;
+
+} // End of 'jobtop_file()'.
+
+
+
+/*======================================================================
+ * FUNCTION:	jobtop_compare()
+ * ARGUMENTS:	Pointers to two processes.
+ * RETURNS:	Negative, zero or positive as first pid is less than,
+ * 		equal to or greater than second.
+ * DESCRIPTION: Function to order processes by pid for qsort() and
+ * 		bsearch().
+ *====================================================================*/
+static int jobtop_compare(const void *first, const void *second)
+{
+	pid_t a = ((const Process*)first)->pid;
+	pid_t b = ((const Process*)second)->pid;
+
+	return (a > b) - (a < b);
+
+} // End of 'jobtop_compare()'.
+
+
+
+/*======================================================================
+ * FUNCTION:	jobtop_find()
+ * ARGUMENTS:	list: Process list sorted by pid.
+ * 		pid:  Process to find.
+ * RETURNS:	Pointer to process, or NULL if not in list.
+ * DESCRIPTION: Function to find a process in a sorted list.
+ *====================================================================*/
+static Process *jobtop_find(Process_list *list, pid_t pid)
+{
+	Process key;
+
+	if(list->count == 0)
+		return NULL;
+
+	key.pid = pid;
+
+	return bsearch(&key, list->processes, list->count, sizeof(Process), jobtop_compare);
+
+} // End of 'jobtop_find()'.
+
+
+
+/*======================================================================
+ * FUNCTION:	jobtop_add()
+ * ARGUMENTS:	list:	 Process list to append to.
+ * 		process: Process to append.
+ * RETURNS:	Operation success or failure.
+ * DESCRIPTION: Function to append a copy of a process to a list,
+ * 		doubling list when it is full.
+ *====================================================================*/
+static Operation jobtop_add(Process_list *list, const Process *process)
+{
+	Process *grown;
+	int capacity;
+
+	if(list->count == list->capacity)
+	{
+		capacity = list->capacity ? 2 * list->capacity : JOBTOP_INITIAL_PROCESSES;
+
+		if((grown = realloc(list->processes, capacity * sizeof(Process))) == NULL)
+		{
+			fprintf(stderr, "jobtop: realloc: Failed to reallocate memory.\n");
+			return FAILURE;
+		}
+		list->processes = grown;
+		list->capacity = capacity;
+	}
+
+	list->processes[list->count++] = *process;
+
+	return SUCCESS;
+
+} // End of 'jobtop_add()'.
+
+
+
+/*======================================================================
+ * FUNCTION:	jobtop_stat()
+ * ARGUMENTS:	job:	 Job being sampled.
+ * 		pid:	 Process to read.
+ * 		process: Process to fill in.
+ * RETURNS:	Operation success, or failure if process has gone.
+ * DESCRIPTION: Function to read parent, process group, threads, CPU
+ * 		ticks and start time of a process from /proc/<pid>/stat.
+ *====================================================================*/
+static Operation jobtop_stat(Job *job, pid_t pid, Process *process)
+{
+	char buffer[JOBTOP_READ_SIZE];
+	char *fields;
+	unsigned long long utime, stime;
+	int ppid, pgid;
+
+	memset(process, 0, sizeof(Process));
+	process->pid = pid;
+
+	// Fields after the command name, which may itself contain spaces.
+	if(jobtop_file(job, pid, "stat", buffer) <= 0 || (fields = strrchr(buffer, ')')) == NULL)
+		return FAILURE;
+
+	if(sscanf(fields + 2, "%*c %d %d %*d %*d %*d %*u %*u %*u %*u %*u %llu %llu %*d %*d %*d %*d %d %*d %llu",
+			&ppid, &pgid, &utime, &stime, &process->threads, &process->start) != 6)
+		return FAILURE;
+
+	process->ppid = (pid_t)ppid;
+	process->pgid = (pid_t)pgid;
+	process->cpu = utime + stime;
+
+	return SUCCESS;
+
+} // End of 'jobtop_stat()'.
+
+
+
+/*======================================================================
+ * FUNCTION:	jobtop_child()
+ * ARGUMENTS:	job:	 Job being sampled.
+ * 		pid:	 Child process found.
+ * 		adopted: Child is of the shell rather than of the job.
+ * RETURNS:	Operation success or failure.
+ * DESCRIPTION: Function to add a child process to scan list.
+ * 		Of the shell's children, only the command, processes in
+ * 		its group and processes already in the job are added,
+ * 		as the rest belong to other stages of a pipeline or were
+ * 		left running by an earlier job. When jobtop is not a
+ * 		pipeline stage, any child started since the command is
+ * 		an orphan of the job too.
+ *====================================================================*/
+static Operation jobtop_child(Job *job, pid_t pid, Boolean adopted)
+{
+	Process process;
+	Process *previous;
+
+	// Child which has already gone is not an error.
+	if(jobtop_stat(job, pid, &process) == FAILURE)
+		return SUCCESS;
+
+	if(adopted && pid != job->root && process.pgid != job->pgid)
+	{
+		previous = jobtop_find(&job->members, pid);
+
+		if((previous == NULL || previous->start != process.start) &&
+				!(job->alone && process.start >= job->start))
+			return SUCCESS;
+	}
+
+	process.member = TRUE;
+
+	return jobtop_add(&job->scan, &process);
+
+} // End of 'jobtop_child()'.
+
+
+
+/*======================================================================
+ * FUNCTION:	jobtop_children()
+ * ARGUMENTS:	job:	 Job being sampled.
+ * 		pid:	 Process to add children of.
+ * 		threads: Threads of process, or 0 if not known.
+ * 		adopted: Process is the shell rather than part of the job.
+ * RETURNS:	Operation success or failure.
+ * DESCRIPTION: Function to add children of every thread of a process
+ * 		to scan list from /proc/<pid>/task/<tid>/children.
+ * 		A single threaded process has its one children file read
+ * 		without listing its task directory.
+ *====================================================================*/
+static Operation jobtop_children(Job *job, pid_t pid, int threads, Boolean adopted)
+{
+	char path[MAX_BUFFER];
+	char buffer[JOBTOP_READ_SIZE];
+	DIR *tasks = NULL;
+	struct dirent *entry;
+	pid_t tid = pid;
+	pid_t child;
+	ssize_t length, i;
+	int fd;
+
+	if(threads != 1)
+	{
+		snprintf(path, sizeof(path), "%d/task", (int)pid);
+		if((fd = openat(dirfd(job->proc), path, O_RDONLY | O_DIRECTORY | O_CLOEXEC)) == -1)
+			return SUCCESS;
+		if((tasks = fdopendir(fd)) == NULL)
+		{
+			close(fd);
+			return SUCCESS;
+		}
+	}
+
+	do
+	{
+		if(tasks != NULL)
+		{
+			if((entry = readdir(tasks)) == NULL)
+				break;
+			if(!isdigit((unsigned char)entry->d_name[0]))
+				continue;
+			tid = (pid_t)atoi(entry->d_name);
+		}
+
+		snprintf(path, sizeof(path), "%d/task/%d/children", (int)pid, (int)tid);
+		if((fd = openat(dirfd(job->proc), path, O_RDONLY | O_CLOEXEC)) == -1)
+			continue;
+
+		// List of pids, each followed by a space, may be longer than buffer.
+		child = 0;
+		while((length = read(fd, buffer, sizeof(buffer))) > 0)
+			for(i = 0; i < length; i++)
+			{
+				if(isdigit((unsigned char)buffer[i]))
+					child = 10 * child + (buffer[i] - '0');
+				else if(child != 0)
+				{
+					if(jobtop_child(job, child, adopted) == FAILURE)
+					{
+						close(fd);
+						if(tasks != NULL)
+							closedir(tasks);
+						return FAILURE;
+					}
+					child = 0;
+				}
+			}
+
+		close(fd);
+	}
+	while(tasks != NULL);
+
+	if(tasks != NULL)
+		closedir(tasks);
+
+	return SUCCESS;
+
+} // End of 'jobtop_children()'.
+
+
+
+/*======================================================================
+ * FUNCTION:	jobtop_walk()
+ * ARGUMENTS:	Job being sampled.
+ * RETURNS:	Operation success or failure.
+ * DESCRIPTION: Function to fill scan list with every process of job,
+ * 		sorted by pid, by following children from the command and
+ * 		from orphans of the job which the shell has adopted.
+ * 		Scan list is itself the queue of processes whose children
+ * 		are still to be read.
+ *====================================================================*/
+static Operation jobtop_walk(Job *job)
+{
+	int i;
+
+	job->scan.count = 0;
+
+	if(jobtop_children(job, getpid(), 0, TRUE) == FAILURE)
+		return FAILURE;
+
+	for(i = 0; i < job->scan.count; i++)
+		if(jobtop_children(job, job->scan.processes[i].pid, job->scan.processes[i].threads, FALSE) == FAILURE)
+			return FAILURE;
+
+	qsort(job->scan.processes, job->scan.count, sizeof(Process), jobtop_compare);
+
+	return SUCCESS;
+
+} // End of 'jobtop_walk()'.
+
+
+
+/*======================================================================
+ * FUNCTION:	jobtop_scan()
+ * ARGUMENTS:	Job being sampled.
+ * RETURNS:	Operation success or failure.
+ * DESCRIPTION: Function to read /proc/<pid>/stat of every process on
+ * 		the system into scan list, sorted by pid.
+ * 		Only used when the shell may not be a subreaper or the
+ * 		kernel does not list children, as descendants which have
+ * 		been reparented to init can then only be found this way.
+ *====================================================================*/
+static Operation jobtop_scan(Job *job)
+{
+	struct dirent *entry;
+	Process process;
+
+	job->scan.count = 0;
+	rewinddir(job->proc);
+
+	while((entry = readdir(job->proc)) != NULL)
+	{
+		if(!isdigit((unsigned char)entry->d_name[0]))
+			continue;
+
+		if(jobtop_stat(job, (pid_t)atoi(entry->d_name), &process) == FAILURE)
+			continue;
+
+		if(jobtop_add(&job->scan, &process) == FAILURE)
+			return FAILURE;
+	}
+
+	qsort(job->scan.processes, job->scan.count, sizeof(Process), jobtop_compare);
+
+	return SUCCESS;
+
+} // End of 'jobtop_scan()'.
+
+
+
+/*======================================================================
+ * FUNCTION:	jobtop_read()
+ * ARGUMENTS:	job:	 Job being sampled.
+ * 		process: Process to read memory and I/O counters of.
+ * RETURNS:	Nothing.
+ * DESCRIPTION: Function to read resident memory and I/O counters of a
+ * 		process. Counters are left at zero if process has gone or
+ * 		its I/O may not be read.
+ *====================================================================*/
+static void jobtop_read(Job *job, Process *process)
+{
+	char buffer[JOBTOP_READ_SIZE];
+	char *line;
+	char *save;
+	unsigned long long value;
+
+	if(jobtop_file(job, process->pid, "statm", buffer) > 0)
+		sscanf(buffer, "%*u %llu", &process->rss);
+
+	if(jobtop_file(job, process->pid, "io", buffer) > 0)
+	{
+		for(line = strtok_r(buffer, "\n", &save); line != NULL; line = strtok_r(NULL, "\n", &save))
+		{
+			if(sscanf(line, "rchar: %llu", &value) == 1)
+				process->read = value;
+			else if(sscanf(line, "wchar: %llu", &value) == 1)
+				process->written = value;
+		}
+	}
+
+} // End of 'jobtop_read()'.
+
+
+
+/*======================================================================
+ * FUNCTION:	jobtop_sample()
+ * ARGUMENTS:	Job to sample.
+ * RETURNS:	Nothing.
+ * DESCRIPTION: Function to find every process of job, and total their
+ * 		memory and the work each has done since previous sample.
+ * 		A process belongs to job if it descends from the command.
+ * 		When every process must be scanned, a process belongs to
+ * 		job if it is in the process group of the command, or its
+ * 		parent belongs to job.
+ * 		Each process is compared against its own previous sample,
+ * 		so processes which exit are credited with work done up to
+ * 		their last sample and never reduce the totals.
+ * 		A parent which reaps a child has the child's I/O added to
+ * 		its own, so what the child had at its last sample is taken
+ * 		off the parent's, as it was counted already.
+ *====================================================================*/
+static void jobtop_sample(Job *job)
+{
+	Process *process;
+	Process *parent;
+	Process *previous;
+	Process_list swap;
+	Boolean changed = TRUE;
+	int i;
+
+	if(!job->full_scan)
+	{
+		if(jobtop_walk(job) == FAILURE)
+			return;
+		changed = FALSE;
+	}
+	else if(jobtop_scan(job) == FAILURE)
+		return;
+	else
+		for(i = 0; i < job->scan.count; i++)
+		{
+			process = &job->scan.processes[i];
+			process->member = (process->pid == job->root || process->pgid == job->pgid);
+		}
+
+	// Add descendants which left process group, until none are left to add.
+	while(changed)
+	{
+		changed = FALSE;
+		for(i = 0; i < job->scan.count; i++)
+		{
+			process = &job->scan.processes[i];
+			if(!process->member && (parent = jobtop_find(&job->scan, process->ppid)) != NULL && parent->member)
+				process->member = changed = TRUE;
+		}
+	}
+
+	job->count = 0;
+	job->cpu = job->rss = job->read = job->written = 0;
+	job->next.count = 0;
+
+	for(i = 0; i < job->scan.count; i++)
+	{
+		process = &job->scan.processes[i];
+		if(!process->member)
+			continue;
+
+		// Process started since previous sample did all of its work since then.
+		if((previous = jobtop_find(&job->members, process->pid)) != NULL && previous->start != process->start)
+			previous = NULL;
+
+		// I/O of a process which may no longer be read stays as last sampled.
+		if(previous)
+		{
+			process->read = previous->read;
+			process->written = previous->written;
+		}
+
+		jobtop_read(job, process);
+
+		process->read_delta = process->read - (previous && previous->read <= process->read ? previous->read : 0);
+		process->written_delta = process->written - (previous && previous->written <= process->written ? previous->written : 0);
+
+		job->count++;
+		job->rss += process->rss;
+		job->cpu += process->cpu - (previous && previous->cpu <= process->cpu ? previous->cpu : 0);
+
+		if(jobtop_add(&job->next, process) == FAILURE)
+			break;
+	}
+
+	// Processes which have gone were reaped, most likely by a parent in job.
+	for(i = 0; i < job->members.count; i++)
+	{
+		previous = &job->members.processes[i];
+		if((process = jobtop_find(&job->next, previous->pid)) != NULL && process->start == previous->start)
+			continue;
+
+		if((parent = jobtop_find(&job->next, previous->ppid)) != NULL)
+		{
+			parent->read_delta -= (previous->read < parent->read_delta ? previous->read : parent->read_delta);
+			parent->written_delta -= (previous->written < parent->written_delta ? previous->written : parent->written_delta);
+		}
+	}
+
+	for(i = 0; i < job->next.count; i++)
+	{
+		job->read += job->next.processes[i].read_delta;
+		job->written += job->next.processes[i].written_delta;
+	}
+
+	// Processes of this sample become previous sample of next.
+	swap = job->members;
+	job->members = job->next;
+	job->next = swap;
+
+	if(!job->sampled)
+		job->first_rss = job->rss;
+	if(job->rss > job->peak_rss)
+		job->peak_rss = job->rss;
+	if(job->count > job->peak_count)
+		job->peak_count = job->count;
+
+	job->sampled = TRUE;
+
+} // End of 'jobtop_sample()'.
+
+
+
+/*======================================================================
+ * FUNCTION:	jobtop_foreground()
+ * ARGUMENTS:	Process group to give terminal to.
+ * RETURNS:	Nothing.
+ * DESCRIPTION: Function to give the terminal to a process group,
+ * 		which a process outside the foreground group may only do
+ * 		while ignoring the stop signal it would otherwise get.
+ *====================================================================*/
+static void jobtop_foreground(pid_t pgid)
+{
+	signal(SIGTTOU, SIG_IGN);
+	tcsetpgrp(STDIN_FD, pgid);
+	signal(SIGTTOU, SIG_DFL);
+
+} // End of 'jobtop_foreground()'.
+
+
+
+/*======================================================================
+ * FUNCTION:	jobtop_subreaper()
+ * ARGUMENTS:	Boolean true when a job starts, false when it ends.
+ * RETURNS:	Boolean true when shell is a subreaper.
+ * 		Boolean false when it could not be made one.
+ * DESCRIPTION: Function to make the shell a child subreaper while any
+ * 		job runs, as jobs in a pipeline may overlap. Orphans left
+ * 		running by a job stay children of the shell, and are
+ * 		reaped by main() once they exit.
+ *====================================================================*/
+static Boolean jobtop_subreaper(Boolean start)
+{
+	Boolean set;
+
+	pthread_mutex_lock(&subreaper_lock);
+
+	if(start && subreaper_jobs++ == 0)
+		subreaper_set = (prctl(PR_SET_CHILD_SUBREAPER, 1) == 0);
+	else if(!start && --subreaper_jobs == 0 && subreaper_set)
+	{
+		prctl(PR_SET_CHILD_SUBREAPER, 0);
+		subreaper_set = FALSE;
+	}
+	set = subreaper_set;
+
+	pthread_mutex_unlock(&subreaper_lock);
+
+	return set;
+
+} // End of 'jobtop_subreaper()'.
+
+
+
+/*======================================================================
+ * FUNCTION:	jobtop_command()
+ * ARGUMENTS:	Command line parsed into strings for each argument.
+ * RETURNS:	Boolean true when user has called 'jobtop'.
+ * 		Boolean false when user has not.
+ * DESCRIPTION: Function to run a command and monitor its process tree
+ * 		when builtin command 'jobtop' called.
+ * 		Command is started in a process group of its own, which
+ * 		is given the terminal if the shell has it, and interrupts
+ * 		received by the shell are passed on to it.
+ * 		Shell has no job control to resume a stopped command
+ * 		later, so if command is stopped the terminal is taken
+ * 		back and its process group is terminated.
+ * 		Every interval a line is printed to stderr showing the
+ * 		number of processes, CPU%, resident memory and growth
+ * 		since the first sample, and read and write throughput.
+ * 		Option '-d msec' sets the sampling interval.
+ *====================================================================*/
+Boolean jobtop_command(char** cmd_line)
+{
+	Job *job;
+	Process process;
+	pid_t child_pid;
+	pid_t waited;
+	int child_status;
+	struct timespec now, last, start, slice;
+	long interval = JOBTOP_INTERVAL_MS;
+	long ticks = sysconf(_SC_CLK_TCK);
+	long page_kib = sysconf(_SC_PAGESIZE) / 1024;
+	double elapsed;
+	char **command = &cmd_line[1];
+	sig_atomic_t interrupts = interrupt_count;
+	Boolean terminal;
+
+	// If user has not called 'jobtop':
+	if(strcmp(cmd_line[0],"jobtop") != 0)
+		return FALSE;
+
+	if(command[0] != NULL && strcmp(command[0],"-d") == 0 && command[1] != NULL)
+	{
+		if((interval = atol(command[1])) < JOBTOP_POLL_MS)
+			interval = JOBTOP_POLL_MS;
+		command += 2;
+	}
+
+	if(command[0] == NULL)
+	{
+		fprintf(stderr, "jobtop: No command given. Try 'help jobtop'.\n");
+		return TRUE;
+	}
+
+	if((job = calloc(1, sizeof(Job))) == NULL)
+	{
+		fprintf(stderr, "jobtop: calloc: Failed to allocate memory.\n");
+		return TRUE;
+	}
+
+	if((job->proc = opendir("/proc")) == NULL)
+	{
+		perror("jobtop: opendir(/proc)");
+		free(job);
+		return TRUE;
+	}
+
+	// Command may only be given terminal if it reads it and shell has it.
+	terminal = (builtin_in == NULL && isatty(STDIN_FD) && tcgetpgrp(STDIN_FD) == getpgrp());
+
+	// Without both, orphans of the job can only be found by reading every process.
+	job->full_scan = (!jobtop_subreaper(TRUE) ||
+			faccessat(dirfd(job->proc), "thread-self/children", R_OK, 0) == -1);
+
+	child_pid = traced_fork();
+
+	if(child_pid == -1)
+	{
+		perror("jobtop: fork()");
+		jobtop_subreaper(FALSE);
+		closedir(job->proc);
+		free(job);
+		return TRUE;
+	}
+
+	// In child process:
+	if(child_pid == 0)
+	{
+		// Both processes set group and terminal, so neither order can race.
+		setpgid(0, 0);
+		if(terminal)
+			jobtop_foreground(getpid());
+
+		// Command reads input pipe of stage, which jobtop itself never reads.
+		if(builtin_in != NULL)
+			dup2(fileno(builtin_in), STDIN_FD);
+
+		builtin_child_fds();
+		child_exec(command);
+	}
+
+	setpgid(child_pid, child_pid);
+	if(terminal)
+		tcsetpgrp(STDIN_FD, child_pid);
+
+	catch_parent_signals("jobtop");
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	last = start;
+	slice.tv_sec = 0;
+	slice.tv_nsec = JOBTOP_POLL_MS * 1000000L;
+
+	job->root = job->pgid = child_pid;
+	job->alone = (builtin_in == NULL && builtin_out == NULL && jobtop_stat(job, child_pid, &process) == SUCCESS);
+	job->start = process.start;
+	jobtop_sample(job);
+
+	// Check for exit often, but only sample /proc once per interval.
+	while((waited = waitpid(child_pid, &child_status, WNOHANG | WUNTRACED)) == 0 ||
+			(waited == child_pid && WIFSTOPPED(child_status)))
+	{
+		if(waited == child_pid)
+		{
+			if(terminal)
+			{
+				jobtop_foreground(getpgrp());
+				terminal = FALSE;
+			}
+
+			fprintf(stderr, "jobtop: %s stopped by signal %d, terminating it.\n",
+					command[0], WSTOPSIG(child_status));
+			kill(-job->pgid, SIGTERM);
+			kill(-job->pgid, SIGCONT);
+			continue;
+		}
+
+		nanosleep(&slice, NULL);
+
+		// Process group of job does not receive interrupts sent to the shell's.
+		if(interrupts != interrupt_count)
+		{
+			interrupts = interrupt_count;
+			kill(-job->pgid, SIGINT);
+		}
+
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		elapsed = (now.tv_sec - last.tv_sec) + (now.tv_nsec - last.tv_nsec) / 1e9;
+
+		if(elapsed * 1000 < interval)
+			continue;
+
+		jobtop_sample(job);
+
+		fprintf(stderr, "jobtop: pid %d pgid %d  procs %3d  cpu %6.1f%%  rss %8llu KiB (%+lld)  read %9.1f KiB/s  write %9.1f KiB/s\n",
+				(int)child_pid, (int)job->pgid, job->count,
+				100.0 * job->cpu / ticks / elapsed,
+				job->rss * page_kib,
+				((long long)job->rss - (long long)job->first_rss) * page_kib,
+				job->read / 1024.0 / elapsed,
+				job->written / 1024.0 / elapsed);
+
+		last = now;
+	}
+
+	TRACE(TRACE_EXIT, PHASE_INSTANT, child_status);
+
+	jobtop_subreaper(FALSE);
+
+	// Take terminal back, which shell is not in foreground to do.
+	if(terminal)
+		jobtop_foreground(getpgrp());
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	elapsed = (now.tv_sec - start.tv_sec) + (now.tv_nsec - start.tv_nsec) / 1e9;
+
+	fprintf(stderr, "jobtop: %s finished after %.2f s, peak %d process(es), peak rss %llu KiB.\n",
+			command[0], elapsed, job->peak_count, job->peak_rss * page_kib);
+
+	closedir(job->proc);
+	free(job->scan.processes);
+	free(job->members.processes);
+	free(job->next.processes);
+	free(job);
+
+	return TRUE;
+
+} // End of 'jobtop_command()'.
@@ -33,6 +33,7 @@ Systems header files
 #include <signal.h>	// For signal(), SIGINT, SIGQUIT
 #include <fcntl.h>	// For open(), dup2()
 #include <errno.h>	// For perror(), errno
+#include <sys/wait.h>	// For waitpid()
 
 #include "config.h"
 #include "header.h"
@@ -64,6 +65,7 @@ int main(void)
 	char *filename;
 	int f;				// File descriptor if file is opened.
 	int save_out;			// To hold stdout file descriptor/ 
+	unsigned long long prof_start;	// Start time of phase measured for 'shellprof'.
 
 
 	// Upon startup of shell, print a welcome message and some inportant information:
@@ -73,6 +75,10 @@ int main(void)
 	}
 
 
+	// Allocate ring buffer used by builtin command 'trace':
+	trace_init();
+
+
 	// Set function to handle quit signal received:
 	// If unable to set signal handler function, terminate with failure.
 	if(signal(SIGQUIT, sig_handler) == SIG_ERR)
@@ -85,11 +91,17 @@ int main(void)
 	// The following loop is responsible for the majority of the functionality of the shell:
 	while(length != -1)
 	{
+		// Reap orphans adopted by 'jobtop' which have since exited.
+		// No other child is left running when prompt is printed.
+		while(waitpid(-1, NULL, WNOHANG) > 0);
+
 		// Print shell prompt in command line:
+		PROF_BEGIN(prof_start, prompt);
 		if(shell_prompt() == P_FAILURE)
 		{
 			fprintf(stderr, "main(): An error occured while printing shell prompt.\n");
 		}
+		PROF_END(prof_start, PROF_PROMPT, prompt);
 		
 
 		// Set function to handle interrupt signal received before fork() called:
@@ -102,7 +114,13 @@ int main(void)
 		
 
 		// Read in line from stdin:
-		if((length = getline(&cmd_line,&buffer_size,stdin)) == -1)
+		TRACE(TRACE_READ, PHASE_BEGIN, 0);
+		PROF_BEGIN(prof_start, read);
+		length = getline(&cmd_line,&buffer_size,stdin);
+		PROF_END(prof_start, PROF_READ, read);
+		TRACE(TRACE_READ, PHASE_END, length);
+
+		if(length == -1)
 		{
 			// Continue to next iteration of while loop.
 			// Loop condition will fail and program will terminate..
@@ -120,6 +138,7 @@ int main(void)
 		// If redirect used, first token will be a command and arguments.
 		// 		     second token will be a filename.
 		// If redirect not used, second token will be NULL.
+		PROF_BEGIN(prof_start, redirect);
 		cmd_line = strtok(cmd_line,">");
 		filename = strtok(NULL,">");
 
@@ -132,29 +151,37 @@ int main(void)
 			fprintf(stderr, "main(): Failed to redirect stdout to file '%s'.\n", filename);
 			filename = NULL;
 		}
+		PROF_END(prof_start, PROF_REDIRECT, redirect);
 		
 
 		// Attempt to parse command line before redirect character into an array of commands
 		// and arguments.
+		TRACE(TRACE_PARSE, PHASE_BEGIN, 0);
+		PROF_BEGIN(prof_start, parse);
 		if(parse_cmd(cmd_line, &command) != SUCCESS)
 		{
 			fprintf(stderr, "main(): Failed to parse command line input.\n");
 		}
+		PROF_END(prof_start, PROF_PARSE, parse);
+		TRACE(TRACE_PARSE, PHASE_END, 0);
 
 
 		// If a command was entered in the command line:
 		if(command[0] != NULL)
 		{
-			// First check if a builtint command was issued:
+			// First check if commands were joined into a pipeline:
+			// If they were, run every stage and wait for them to finish.
+			if(pipeline(command));
+
+			// Then check if a builtint command was issued:
 
 			// Check if 'logout' or 'exit' command was issued:
 			// If it was, cause while loop condition to fail and process to terminate.
-			if((strcmp(command[0], "logout") == 0) || (strcmp(command[0], "exit") == 0))
+			else if((strcmp(command[0], "logout") == 0) || (strcmp(command[0], "exit") == 0))
 				length = -1;
 
 
-			else if(help(command));
-			else if(change_directory(command));
+			else if(run_builtin(command));
 
 
 			// If a builtin command was not issued:
@@ -185,6 +212,8 @@ int main(void)
 		if(filename != NULL)
 		{	
 			// Return output to normal:
+			// Flush anything builtins printed so it reaches the file.
+			fflush(stdout);
 			dup2(save_out,1);
 			
 			// Close open files:
@@ -0,0 +1,311 @@
+/*======================================================================
+
+	University College Dublin
+	COMP20200 - UNIX Programming
+
+	Assignment 2: 	Implement a simple shell
+
+	Project:	assign2_19351611
+	File Name:   	pipeline.c
+	Description: 	Simple UNIX shell program.
+			Reads line from stdin and executes command.
+			This file contains the functions used to run
+			commands joined by the pipe symbol '|'.
+			External commands are run as child processes.
+			Builtin commands are run on a thread within the
+			shell, reading and writing their pipe directly,
+			so they cost no fork(). Builtins which change
+			directory are run in a child process instead, as
+			a subshell would, so other stages never see the
+			environment change under them.
+
+			These include:
+				> builtin_child_fds()
+				> pipeline_thread()
+				> pipeline_child()
+				> pipeline()
+
+	Author:      	Cian O'Mahoney
+	Student Number:	19351611
+	Email:		cian.omahoney@ucdconnect.ie
+	Date:        	15/2/2021
+	Version:     	1.0
+
+======================================================================*/
+
+
+
+/*======================================================================
+Systems header files
+======================================================================*/
+#define _GNU_SOURCE	// For pipe2()
+
+#include <config.h>
+#include "header.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>	// For strcmp()
+#include <unistd.h>	// For pipe2(), dup2(), close(), fork()
+#include <fcntl.h>	// For O_CLOEXEC
+#include <signal.h>	// For signal(), pthread_sigmask()
+#include <pthread.h>	// For pthread_create(), pthread_join()
+#include <sys/wait.h>	// For waitpid()
+
+
+
+/*======================================================================
+ State of a single pipeline stage
+======================================================================*/
+typedef struct
+{
+	char **argv;		// Command and arguments, NULL terminated.
+	int in_fd;		// Read end of previous pipe, or -1 for stdin.
+	int out_fd;		// Write end of next pipe, or -1 for stdout.
+	Boolean builtin;	// Run on thread rather than child process.
+	pid_t pid;		// Child process identifier, if external.
+	pthread_t thread;	// Thread identifier, if builtin.
+	Boolean started;	// Stage was successfully started.
+} Stage;
+
+
+__thread FILE *builtin_in = NULL;	// Stdin of builtin on this thread.
+__thread FILE *builtin_out = NULL;	// Stdout of builtin on this thread.
+
+
+
+/*======================================================================
+ * FUNCTION:	builtin_child_fds()
+ * ARGUMENTS:	None.
+ * RETURNS:	Nothing.
+ * DESCRIPTION: Function to be called in a child forked by a builtin
+ * 		command before exec.
+ * 		If builtin is running as a pipeline stage, its output pipe
+ * 		becomes stdout of the child and signals blocked on the
+ * 		stage thread are unblocked again.
+ *====================================================================*/
+void builtin_child_fds(void)
+{
+	sigset_t mask;
+
+	if(builtin_out != NULL)
+	{
+		fflush(builtin_out);
+		dup2(fileno(builtin_out), STDOUT_FD);
+	}
+
+	sigemptyset(&mask);
+	sigprocmask(SIG_SETMASK, &mask, NULL);
+
+} // End of 'builtin_child_fds()'.
+
+
+
+/*======================================================================
+ * FUNCTION:	pipeline_thread()
+ * ARGUMENTS:	Pointer to stage to run.
+ * RETURNS:	NULL.
+ * DESCRIPTION: Function run on a new thread for each builtin stage.
+ * 		Pipe descriptors are given to this thread's builtin
+ * 		streams and closed once builtin returns, so the next
+ * 		stage sees end of file.
+ * 		SIGPIPE is blocked so a closed reader makes writes fail
+ * 		instead of terminating the shell. Interrupt and quit are
+ * 		left for the main thread to handle.
+ *====================================================================*/
+static void *pipeline_thread(void *arg)
+{
+	Stage *stage = arg;
+	sigset_t mask;
+
+	sigemptyset(&mask);
+	sigaddset(&mask, SIGPIPE);
+	sigaddset(&mask, SIGINT);
+	sigaddset(&mask, SIGQUIT);
+	pthread_sigmask(SIG_BLOCK, &mask, NULL);
+
+	if(stage->in_fd != -1 && (builtin_in = fdopen(stage->in_fd, "r")) == NULL)
+	{
+		perror("pipeline(): fdopen()");
+		close(stage->in_fd);
+	}
+	if(stage->out_fd != -1 && (builtin_out = fdopen(stage->out_fd, "w")) == NULL)
+	{
+		perror("pipeline(): fdopen()");
+		close(stage->out_fd);
+	}
+
+	// Only run builtin if both of its streams are available.
+	if((stage->in_fd == -1 || builtin_in != NULL) && (stage->out_fd == -1 || builtin_out != NULL))
+		run_builtin(stage->argv);
+
+	if(builtin_out != NULL)
+		fclose(builtin_out);
+	else if(stage->out_fd == -1)
+		fflush(stdout);
+
+	if(builtin_in != NULL)
+		fclose(builtin_in);
+
+	return NULL;
+
+} // End of 'pipeline_thread()'.
+
+
+
+/*======================================================================
+ * FUNCTION:	pipeline_child()
+ * ARGUMENTS:	Pointer to stage to run.
+ * RETURNS:	Operation success or failure.
+ * DESCRIPTION: Function to fork a child process for an external stage.
+ * 		Child connects its pipes to stdin and stdout then
+ * 		replaces itself with command. Parent closes its copy
+ * 		of the pipe descriptors.
+ * 		A builtin which changes shell state is run by the child
+ * 		itself, so its changes are lost when the child exits.
+ *====================================================================*/
+static Operation pipeline_child(Stage *stage)
+{
+	stage->pid = traced_fork();
+
+	if(stage->pid == -1)
+	{
+		perror("pipeline(): fork()");
+		return FAILURE;
+	}
+
+	// In child process:
+	if(stage->pid == 0)
+	{
+		if(stage->in_fd != -1) dup2(stage->in_fd, STDIN_FD);
+		if(stage->out_fd != -1) dup2(stage->out_fd, STDOUT_FD);
+
+		// Directory is left when child exits, so it is not a visit worth recording.
+		if(is_builtin(stage->argv[0]))
+		{
+			record_visits = FALSE;
+			run_builtin(stage->argv);
+			fflush(stdout);
+			_exit(EXIT_SUCCESS);
+		}
+
+		child_exec(stage->argv);
+	}
+
+	return SUCCESS;
+
+} // End of 'pipeline_child()'.
+
+
+
+/*======================================================================
+ * FUNCTION:	pipeline()
+ * ARGUMENTS:	Command line parsed into strings for each argument.
+ * RETURNS:	Boolean true when command line contains a pipeline.
+ * 		Boolean false when it does not.
+ * DESCRIPTION: Function to run each command separated by '|' with
+ * 		stdout of each command connected to stdin of the next.
+ * 		Builtin stages run on threads, external stages run as
+ * 		child processes. Waits for every stage to finish.
+ *====================================================================*/
+Boolean pipeline(char** cmd_line)
+{
+	Stage *stages;
+	int count = 1;
+	int fds[2];
+	int child_status;
+	int length;
+	int i, j;
+
+	// Count stages, returning if command line contains no pipe.
+	for(length = 0; cmd_line[length] != NULL; length++)
+		if(strcmp(cmd_line[length], PIPE_SYMBOL) == 0)
+			count++;
+
+	if(count == 1)
+		return FALSE;
+
+	if((stages = calloc(count, sizeof(Stage))) == NULL)
+	{
+		fprintf(stderr, "pipeline(): calloc: Failed to allocate memory.\n");
+		return TRUE;
+	}
+
+	// Split command line into NULL terminated argument arrays.
+	stages[0].argv = cmd_line;
+	for(i = 0, j = 1; i < length; i++)
+		if(strcmp(cmd_line[i], PIPE_SYMBOL) == 0)
+		{
+			cmd_line[i] = NULL;
+			stages[j++].argv = &cmd_line[i + 1];
+		}
+
+	for(i = 0; i < count; i++)
+		if(stages[i].argv[0] == NULL)
+		{
+			fprintf(stderr, "%s: Syntax error: missing command around '%s'.\n", PACKAGE, PIPE_SYMBOL);
+			free(stages);
+			return TRUE;
+		}
+
+	catch_parent_signals("pipeline()");
+
+	fflush(stdout);
+
+	// Start every stage, creating pipe to next stage as we go.
+	stages[0].in_fd = -1;
+	for(i = 0; i < count; i++)
+	{
+		stages[i].out_fd = -1;
+
+		if(i < count - 1)
+		{
+			if(pipe2(fds, O_CLOEXEC) == -1)
+			{
+				perror("pipeline(): pipe2()");
+				if(stages[i].in_fd != -1) close(stages[i].in_fd);
+				break;
+			}
+			stages[i].out_fd = fds[1];
+			stages[i+1].in_fd = fds[0];
+		}
+
+		stages[i].builtin = is_builtin(stages[i].argv[0]) && !changes_shell_state(stages[i].argv[0]);
+
+		if(stages[i].builtin)
+		{
+			// Thread takes ownership of pipe descriptors.
+			if(pthread_create(&stages[i].thread, NULL, pipeline_thread, &stages[i]) != 0)
+			{
+				fprintf(stderr, "pipeline(): pthread_create(): Failed to start '%s'.\n", stages[i].argv[0]);
+				if(stages[i].in_fd != -1) close(stages[i].in_fd);
+				if(stages[i].out_fd != -1) close(stages[i].out_fd);
+			}
+			else
+				stages[i].started = TRUE;
+		}
+		else
+		{
+			stages[i].started = (pipeline_child(&stages[i]) == SUCCESS);
+			if(stages[i].in_fd != -1) close(stages[i].in_fd);
+			if(stages[i].out_fd != -1) close(stages[i].out_fd);
+		}
+	}
+
+	// Wait for every stage to finish.
+	for(i = 0; i < count; i++)
+	{
+		if(!stages[i].started)
+			continue;
+
+		if(stages[i].builtin)
+			pthread_join(stages[i].thread, NULL);
+		else if(waitpid(stages[i].pid, &child_status, 0) > 0)
+			TRACE(TRACE_EXIT, PHASE_INSTANT, child_status);
+	}
+
+	free(stages);
+
+	return TRUE;
+
+} // End of 'pipeline()'.
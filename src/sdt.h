@@ -0,0 +1,79 @@
+/*======================================================================
+
+	University College Dublin
+	COMP20200 - UNIX Programming
+
+	Assignment 2: 	Implement a simple shell
+
+	Project:	assign2_19351611
+	File Name:   	sdt.h
+	Description: 	Simple UNIX shell program.
+			Reads line from stdin and executes command.
+			This file contains the macros used to place static
+			probe points in the shell. Each probe is a single
+			'nop' described by an ELF note in the format of
+			systemtap's <sys/sdt.h>, so perf, bpftrace and gdb
+			can find and attach to it without the systemtap
+			headers being installed.
+
+			These include:
+				> DTRACE_PROBE()
+				> DTRACE_PROBE1()
+
+	Author:      	Cian O'Mahoney
+	Student Number:	19351611
+	Email:		cian.omahoney@ucdconnect.ie
+	Date:        	15/2/2021
+	Version:     	1.0
+
+======================================================================*/
+
+#ifndef SDT_H_INCLUDED
+#define SDT_H_INCLUDED
+
+#if defined(__GNUC__) && defined(__ELF__) && (defined(__x86_64__) || defined(__aarch64__))
+
+// Note holds address of probe, address of base section used to find
+// load bias, a zero semaphore, provider, name and argument description.
+#define SDT_NOTE(provider, name, args) \
+	"990:	nop\n" \
+	".pushsection .note.stapsdt,\"?\",\"note\"\n" \
+	".balign 4\n" \
+	".4byte 992f-991f, 994f-993f, 3\n" \
+	"991:	.asciz \"stapsdt\"\n" \
+	"992:	.balign 4\n" \
+	"993:	.8byte 990b\n" \
+	".8byte _.stapsdt.base\n" \
+	".8byte 0\n" \
+	".asciz \"" #provider "\"\n" \
+	".asciz \"" #name "\"\n" \
+	".asciz \"" args "\"\n" \
+	"994:	.balign 4\n" \
+	".popsection\n" \
+	".ifndef _.stapsdt.base\n" \
+	".pushsection .stapsdt.base,\"aG\",\"progbits\",.stapsdt.base,comdat\n" \
+	".weak _.stapsdt.base\n" \
+	".hidden _.stapsdt.base\n" \
+	"_.stapsdt.base: .space 1\n" \
+	".size _.stapsdt.base, 1\n" \
+	".popsection\n" \
+	".endif\n"
+
+#define DTRACE_PROBE(provider, name) \
+	__asm__ __volatile__(SDT_NOTE(provider, name, ""))
+
+// Argument is described as a signed 8 byte value in a register,
+// memory or immediate operand.
+#define DTRACE_PROBE1(provider, name, arg) \
+	__asm__ __volatile__(SDT_NOTE(provider, name, "-8@%0") :: "nor"((long long)(arg)))
+
+#else
+
+#warning "Static probe points are not supported on this target and are disabled."
+
+#define DTRACE_PROBE(provider, name) do { } while(0)
+#define DTRACE_PROBE1(provider, name, arg) do { (void)(arg); } while(0)
+
+#endif
+
+#endif
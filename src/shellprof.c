@@ -0,0 +1,198 @@
+/*======================================================================
+
+	University College Dublin
+	COMP20200 - UNIX Programming
+
+	Assignment 2: 	Implement a simple shell
+
+	Project:	assign2_19351611
+	File Name:   	shellprof.c
+	Description: 	Simple UNIX shell program.
+			Reads line from stdin and executes command.
+			This file contains the functions used to measure
+			time the shell itself spends in each phase of
+			handling a command line, and the builtin command
+			'shellprof' which prints them as histograms.
+
+			These include:
+				> prof_clock()
+				> prof_record()
+				> prof_print()
+				> shellprof_command()
+
+	Author:      	Cian O'Mahoney
+	Student Number:	19351611
+	Email:		cian.omahoney@ucdconnect.ie
+	Date:        	15/2/2021
+	Version:     	1.0
+
+======================================================================*/
+
+
+
+/*======================================================================
+Systems header files
+======================================================================*/
+#include <config.h>
+#include "header.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>	// For strcmp(), memset()
+#include <time.h>	// For clock_gettime()
+
+
+
+/*======================================================================
+ Counters kept for each phase
+======================================================================*/
+typedef struct
+{
+	unsigned long long count;			// Times phase measured.
+	unsigned long long total;			// Sum of durations in ns.
+	unsigned long long max;				// Longest duration in ns.
+	unsigned long long buckets[PROF_BUCKETS];	// Bucket i counts durations
+							// in [2^i, 2^(i+1)) ns.
+} Prof_counter;
+
+
+static Prof_counter counters[PROF_PHASES];
+
+static const char *phase_names[PROF_PHASES] = {"prompt", "read", "parse", "redirect", "dispatch", "fork"};
+
+
+
+/*======================================================================
+ * FUNCTION:	prof_clock()
+ * ARGUMENTS:	None.
+ * RETURNS:	Monotonic time in nanoseconds.
+ * DESCRIPTION: Function to read monotonic clock.
+ * 		On Linux this is served by the vDSO without a system call.
+ *====================================================================*/
+unsigned long long prof_clock(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (unsigned long long)now.tv_sec * 1000000000ULL + (unsigned long long)now.tv_nsec;
+
+} // End of 'prof_clock()'.
+
+
+
+/*======================================================================
+ * FUNCTION:	prof_record()
+ * ARGUMENTS:	phase:	  Phase of shell measured.
+ * 		duration: Time spent in phase in nanoseconds.
+ * RETURNS:	Nothing.
+ * DESCRIPTION: Function to add a measurement to counters of a phase.
+ * 		Counters are updated atomically as builtins running in
+ * 		pipeline threads may fork at the same time.
+ *====================================================================*/
+void prof_record(Prof_phase phase, unsigned long long duration)
+{
+	Prof_counter *counter = &counters[phase];
+	unsigned long long max;
+	int bucket = 0;
+
+	// Find highest set bit of duration.
+	if(duration > 0)
+		bucket = 63 - __builtin_clzll(duration);
+	if(bucket >= PROF_BUCKETS)
+		bucket = PROF_BUCKETS - 1;
+
+	__atomic_fetch_add(&counter->count, 1, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&counter->total, duration, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&counter->buckets[bucket], 1, __ATOMIC_RELAXED);
+
+	max = __atomic_load_n(&counter->max, __ATOMIC_RELAXED);
+	while(duration > max &&
+		!__atomic_compare_exchange_n(&counter->max, &max, duration, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+} // End of 'prof_record()'.
+
+
+
+/*======================================================================
+ * FUNCTION:	prof_print()
+ * ARGUMENTS:	Phase to print.
+ * RETURNS:	Nothing.
+ * DESCRIPTION: Function to print summary and histogram of a phase,
+ * 		with one row for each non-empty bucket.
+ *====================================================================*/
+static void prof_print(Prof_phase phase)
+{
+	Prof_counter *counter = &counters[phase];
+	unsigned long long peak = 0;
+	int i, bar;
+
+	fprintf(BUILTIN_OUT, "\n%s:\tcount %llu  mean %llu ns  max %llu ns  total %.3f ms\n",
+			phase_names[phase], counter->count,
+			counter->count ? counter->total / counter->count : 0,
+			counter->max, counter->total / 1e6);
+
+	for(i = 0; i < PROF_BUCKETS; i++)
+		if(counter->buckets[i] > peak)
+			peak = counter->buckets[i];
+
+	for(i = 0; i < PROF_BUCKETS; i++)
+	{
+		if(counter->buckets[i] == 0)
+			continue;
+
+		fprintf(BUILTIN_OUT, "\t%12llu ns | ", 1ULL << i);
+		for(bar = 0; bar < (int)(counter->buckets[i] * PROF_BAR_WIDTH / peak); bar++)
+			fputc('#', BUILTIN_OUT);
+		fprintf(BUILTIN_OUT, " %llu\n", counter->buckets[i]);
+	}
+
+} // End of 'prof_print()'.
+
+
+
+/*======================================================================
+ * FUNCTION:	shellprof_command()
+ * ARGUMENTS:	Command line parsed into strings for each argument.
+ * RETURNS:	Boolean true when user has called 'shellprof'.
+ * 		Boolean false when user has not.
+ * DESCRIPTION: Function to print time spent by the shell in each
+ * 		phase when builtin command 'shellprof' called.
+ * 			shellprof:	  Print every phase.
+ * 			shellprof phase:  Print a single phase.
+ * 			shellprof reset:  Clear all counters.
+ *====================================================================*/
+Boolean shellprof_command(char** cmd_line)
+{
+	int i;
+
+	// If user has not called 'shellprof':
+	if(strcmp(cmd_line[0],"shellprof") != 0)
+		return FALSE;
+
+	if(cmd_line[1] == NULL)
+	{
+		for(i = 0; i < PROF_PHASES; i++)
+			prof_print(i);
+		fprintf(BUILTIN_OUT, "\n");
+	}
+	else if(strcmp(cmd_line[1],"reset") == 0)
+		memset(counters, 0, sizeof(counters));
+	else
+	{
+		for(i = 0; i < PROF_PHASES; i++)
+			if(strcmp(cmd_line[1], phase_names[i]) == 0)
+				break;
+
+		if(i == PROF_PHASES)
+			fprintf(stderr, "shellprof: Unknown phase '%s'. Try 'help shellprof'.\n", cmd_line[1]);
+		else
+		{
+			prof_print(i);
+			fprintf(BUILTIN_OUT, "\n");
+		}
+	}
+
+	return TRUE;
+
+} // End of 'shellprof_command()'.
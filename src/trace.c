@@ -0,0 +1,277 @@
+/*======================================================================
+
+	University College Dublin
+	COMP20200 - UNIX Programming
+
+	Assignment 2: 	Implement a simple shell
+
+	Project:	assign2_19351611
+	File Name:   	trace.c
+	Description: 	Simple UNIX shell program.
+			Reads line from stdin and executes command.
+			This file contains the event tracing functions
+			required to implement 'assign2_19351611'.
+			Events are written as fixed-size records into
+			a ring buffer shared with forked children, and
+			can be exported as Chrome trace JSON.
+
+			These include:
+				> trace_fork_child()
+				> trace_init()
+				> trace_record()
+				> trace_dump()
+				> trace_command()
+
+	Author:      	Cian O'Mahoney
+	Student Number:	19351611
+	Email:		cian.omahoney@ucdconnect.ie
+	Date:        	15/2/2021
+	Version:     	1.0
+
+======================================================================*/
+
+
+
+/*======================================================================
+Systems header files
+======================================================================*/
+#define _GNU_SOURCE	// For gettid()
+
+#include <config.h>
+#include "header.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>	// For uint64_t, uint32_t
+#include <string.h>	// For strcmp(), memset()
+#include <time.h>	// For clock_gettime()
+#include <unistd.h>	// For getpid(), gettid()
+#include <pthread.h>	// For pthread_atfork()
+#include <sys/mman.h>	// For mmap()
+
+
+
+/*======================================================================
+ Trace record and ring buffer layout
+======================================================================*/
+typedef struct
+{
+	uint64_t sequence;	// Slot number plus one, written last.
+	uint64_t timestamp;	// Monotonic time in nanoseconds.
+	int64_t argument;	// Event specific value.
+	uint32_t pid;		// Process which recorded event.
+	uint32_t tid;		// Thread which recorded event.
+	uint8_t event;		// Event type.
+	uint8_t phase;		// Begin, end or instant.
+	uint16_t padding;
+	uint32_t padding2;
+} Trace_record;
+
+typedef struct
+{
+	uint64_t head;		// Number of records ever written.
+	Trace_record records[TRACE_BUFFER_SIZE];
+} Trace_buffer;
+
+
+volatile int trace_enabled = 0;		// Checked by TRACE() macro.
+static Trace_buffer *trace_buffer = NULL;	// Shared with children.
+static uint32_t trace_pid = 0;			// Cached, as getpid() is a system call.
+static __thread uint32_t trace_tid = 0;		// Cached on first record by each thread.
+
+static const char *event_names[] = {"read", "parse", "fork", "exec", "exit", "signal"};
+
+
+
+/*======================================================================
+ * FUNCTION:	trace_fork_child()
+ * ARGUMENTS:	None.
+ * RETURNS:	Nothing.
+ * DESCRIPTION: Function called in every child after fork() to refresh
+ * 		cached process and thread identifiers used by trace_record().
+ * 		Only the forking thread exists in the child, so its thread
+ * 		identifier is the new process identifier.
+ *====================================================================*/
+static void trace_fork_child(void)
+{
+	trace_pid = (uint32_t)getpid();
+	trace_tid = trace_pid;
+
+} // End of 'trace_fork_child()'.
+
+
+
+/*======================================================================
+ * FUNCTION:	trace_init()
+ * ARGUMENTS:	None.
+ * RETURNS:	Nothing.
+ * DESCRIPTION: Function to allocate trace ring buffer.
+ * 		Buffer is mapped shared so events recorded by forked
+ * 		children before exec are visible to the shell.
+ * 		If mapping fails, tracing cannot be enabled.
+ *====================================================================*/
+void trace_init(void)
+{
+	void *map;
+
+	map = mmap(NULL, sizeof(Trace_buffer), PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+
+	if(map == MAP_FAILED)
+	{
+		perror("trace_init(): mmap()");
+		return;
+	}
+
+	trace_buffer = map;
+	trace_pid = (uint32_t)getpid();
+
+	if(pthread_atfork(NULL, NULL, trace_fork_child) != 0)
+		fprintf(stderr, "trace_init(): pthread_atfork(): Failed to register fork handler.\n");
+
+} // End of 'trace_init()'.
+
+
+
+/*======================================================================
+ * FUNCTION:	trace_record()
+ * ARGUMENTS:	event: 	  Type of event to record.
+ * 		phase: 	  Begin, end or instant event.
+ * 		argument: Event specific value, e.g. exit status.
+ * RETURNS:	Nothing.
+ * DESCRIPTION: Function to write a single record into trace ring buffer.
+ * 		Slots are claimed with an atomic increment so no lock is
+ * 		needed and function is safe to call from signal handlers.
+ * 		Sequence number is cleared first and stored last, so
+ * 		trace_dump() can skip records which are being written.
+ *====================================================================*/
+void trace_record(Event event, Phase phase, long argument)
+{
+	struct timespec now;
+	uint64_t slot;
+	Trace_record *record;
+
+	if(trace_buffer == NULL)
+		return;
+
+	if(trace_tid == 0)
+		trace_tid = (uint32_t)gettid();
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	slot = __atomic_fetch_add(&trace_buffer->head, 1, __ATOMIC_RELAXED);
+	record = &trace_buffer->records[slot & (TRACE_BUFFER_SIZE - 1)];
+
+	// Readers must see sequence cleared before any field changes.
+	__atomic_store_n(&record->sequence, 0, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	record->timestamp = (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+	record->argument = argument;
+	record->pid = trace_pid;
+	record->tid = trace_tid;
+	record->event = (uint8_t)event;
+	record->phase = (uint8_t)phase;
+	__atomic_store_n(&record->sequence, slot + 1, __ATOMIC_RELEASE);
+
+} // End of 'trace_record()'.
+
+
+
+/*======================================================================
+ * FUNCTION:	trace_dump()
+ * ARGUMENTS:	None.
+ * RETURNS:	Nothing.
+ * DESCRIPTION: Function to print contents of trace ring buffer to
+ * 		stdout in Chrome trace JSON format.
+ * 		Output can be loaded by chrome://tracing or the
+ * 		Perfetto UI, and may be sent to a file with '>'.
+ *====================================================================*/
+static void trace_dump(void)
+{
+	uint64_t head, slot, first;
+	Trace_record record;
+	Trace_record *slot_record;
+	const char *separator = "";
+
+	head = __atomic_load_n(&trace_buffer->head, __ATOMIC_ACQUIRE);
+	first = (head > TRACE_BUFFER_SIZE) ? head - TRACE_BUFFER_SIZE : 0;
+
+	fprintf(BUILTIN_OUT, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+
+	for(slot = first; slot < head; slot++)
+	{
+		slot_record = &trace_buffer->records[slot & (TRACE_BUFFER_SIZE - 1)];
+
+		// Skip record if it is being written, or was rewritten while copying it.
+		if(__atomic_load_n(&slot_record->sequence, __ATOMIC_ACQUIRE) != slot + 1)
+			continue;
+		record = *slot_record;
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		if(__atomic_load_n(&slot_record->sequence, __ATOMIC_RELAXED) != slot + 1)
+			continue;
+
+		fprintf(BUILTIN_OUT, "%s{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%llu.%03llu,\"pid\":%u,\"tid\":%u",
+				separator, event_names[record.event], record.phase,
+				(unsigned long long)(record.timestamp / 1000),
+				(unsigned long long)(record.timestamp % 1000),
+				record.pid, record.tid);
+
+		if(record.phase == PHASE_INSTANT)
+			fprintf(BUILTIN_OUT, ",\"s\":\"p\"");
+
+		fprintf(BUILTIN_OUT, ",\"args\":{\"value\":%lld}}", (long long)record.argument);
+		separator = ",\n";
+	}
+
+	fprintf(BUILTIN_OUT, "\n]}\n");
+
+} // End of 'trace_dump()'.
+
+
+
+/*======================================================================
+ * FUNCTION:	trace_command()
+ * ARGUMENTS:	Command line parsed into strings for each argument.
+ * RETURNS:	Boolean true when user has called 'trace'.
+ * 		Boolean false when user has not.
+ * DESCRIPTION: Function to control event tracing when builtin
+ * 		command 'trace' called.
+ * 			trace on:	Start recording events.
+ * 			trace off:	Stop recording events.
+ * 			trace clear:	Discard recorded events.
+ * 			trace dump:	Print events as Chrome trace JSON.
+ * 		With no argument, print current tracing state.
+ *====================================================================*/
+Boolean trace_command(char** cmd_line)
+{
+	// If user has not called 'trace':
+	if(strcmp(cmd_line[0],"trace") != 0)
+		return FALSE;
+
+	if(trace_buffer == NULL)
+	{
+		fprintf(stderr, "trace: Trace buffer not available.\n");
+		return TRUE;
+	}
+
+	if(cmd_line[1] == NULL)
+	{
+		uint64_t head = __atomic_load_n(&trace_buffer->head, __ATOMIC_ACQUIRE);
+		fprintf(BUILTIN_OUT, "trace: %s, %llu event(s) recorded, %d held.\n",
+				trace_enabled ? "on" : "off", (unsigned long long)head,
+				head > TRACE_BUFFER_SIZE ? TRACE_BUFFER_SIZE : (int)head);
+	}
+	else if(strcmp(cmd_line[1],"on") == 0)
+		trace_enabled = 1;
+	else if(strcmp(cmd_line[1],"off") == 0)
+		trace_enabled = 0;
+	else if(strcmp(cmd_line[1],"clear") == 0)
+		memset(trace_buffer, 0, sizeof(Trace_buffer));
+	else if(strcmp(cmd_line[1],"dump") == 0)
+		trace_dump();
+	else
+		fprintf(stderr, "trace: Unknown option '%s'. Try 'help trace'.\n", cmd_line[1]);
+
+	return TRUE;
+
+} // End of 'trace_command()'.